@@ -3,41 +3,44 @@
  * @brief Sistema de livro de aberturas para o MaZe
  * @author GustavoGNZ
  * @version 1.0
- * 
+ *
  * Este header contém as declarações para o sistema de livro de aberturas,
  * permitindo que a engine jogue variações diferentes a cada partida.
+ *
+ * O livro é binário, no layout do Polyglot: entradas de 16 bytes (chave,
+ * lance, peso, aprendizado) em big-endian, ordenadas pela chave da posição.
+ * A chave é a chave Zobrist do próprio MaZe, não a do Polyglot, então livros
+ * .bin de outras engines não são compatíveis; como no Polyglot, a coluna en
+ * passant só entra na chave quando a captura é possível. Como a consulta é
+ * pela posição, transposições para linhas do livro também são encontradas.
  */
 
 #ifndef ABERTURAS_H
 #define ABERTURAS_H
 
 #include "bitboard.h"
+#include <stddef.h>
 
 // =============================================================================
 // ESTRUTURAS DE DADOS
 // =============================================================================
 
-#define MAX_LANCES_ABERTURA 20  // Máximo de lances por linha de abertura
-#define MAX_LINHAS_ABERTURA 200 // Máximo de linhas no arquivo de aberturas
-#define MAX_NOME_ABERTURA 100   // Tamanho máximo do nome da abertura
-
-/**
- * @brief Estrutura para armazenar uma linha de abertura
- */
-typedef struct {
-    char nome[MAX_NOME_ABERTURA];           // Nome da abertura (ex: "Ruy Lopez")
-    char lances_str[MAX_LANCES_ABERTURA][6]; // Lances em notação UCI (ex: "e2e4")
-    int lances_codificados[MAX_LANCES_ABERTURA]; // Lances no formato interno
-    int num_lances;                          // Número de lances nesta linha
-} linha_abertura_t;
+#define ARQUIVO_LIVRO_BINARIO "aberturas.bin" // Livro compilado (make livro)
+#define ARQUIVO_LIVRO_TEXTO "aberturas.txt"   // Linhas em UCI, compiladas na memória se não houver o .bin
+#define TAMANHO_ENTRADA_LIVRO 16              // Bytes por entrada no layout Polyglot
+#define MAX_LANCES_ABERTURA 20                // Máximo de lances por linha de aberturas.txt
+#define MAX_CANDIDATOS_LIVRO 64               // Máximo de lances do livro considerados por posição
 
 /**
  * @brief Estrutura principal do livro de aberturas
  */
 typedef struct {
-    linha_abertura_t linhas[MAX_LINHAS_ABERTURA];
-    int num_linhas;
-    int inicializado;
+    const unsigned char *entradas; // Entradas de 16 bytes ordenadas pela chave
+    size_t num_entradas;           // Número de entradas
+    void *memoria;                 // Região mapeada ou alocada que contém as entradas
+    size_t tamanho_memoria;        // Tamanho dessa região em bytes
+    int mapeado;                   // 1 se a região veio de mmap, 0 se de malloc
+    int inicializado;              // 1 se há livro carregado
 } livro_aberturas_t;
 
 // Variável global do livro
@@ -49,82 +52,54 @@ extern livro_aberturas_t livro_aberturas;
 
 /**
  * @brief Inicializa o sistema de livro de aberturas
- * 
- * Carrega o arquivo aberturas.txt e processa todas as linhas,
- * convertendo os lances UCI para formato interno.
- * 
+ *
+ * Mapeia aberturas.bin na memória (somente leitura). Sem ele, compila
+ * aberturas.txt na memória no mesmo formato.
+ *
  * @return 1 se sucesso, 0 se erro
  */
 int inicializar_livro_aberturas();
 
 /**
  * @brief Busca um lance de abertura para a posição atual
- * 
- * Analisa a posição atual (histórico de lances) e busca no livro
- * de aberturas se há alguma linha que corresponde. Se encontrar,
- * retorna um lance aleatório entre as opções válidas.
- * 
- * @param historico_lances Array com os lances jogados até agora
- * @param num_lances_jogados Número de lances já jogados
- * @return Lance codificado se encontrado, 0 se não há lance no livro
+ *
+ * Faz uma busca binária pela chave Zobrist da posição e escolhe um dos
+ * lances encontrados com probabilidade proporcional ao peso. Lances do
+ * livro que não são legais na posição (colisão de chave) são ignorados.
+ *
+ * @param pos Posição atual
+ * @return Lance legal codificado se encontrado, 0 se não há lance no livro
  */
-int buscar_lance_abertura(int historico_lances[], int num_lances_jogados);
+int buscar_lance_abertura(const posicao_t *pos);
 
 /**
- * @brief Verifica se a engine ainda está "em livro"
- * 
- * Determina se a posição atual ainda corresponde a alguma linha
- * conhecida do livro de aberturas.
- * 
- * @param historico_lances Array com os lances jogados até agora
- * @param num_lances_jogados Número de lances já jogados
- * @return 1 se ainda está em livro, 0 caso contrário
+ * @brief Compila um arquivo de linhas em UCI para o livro binário
+ *
+ * Cada linha não comentada de arquivo_texto é jogada a partir da posição
+ * inicial; cada par (posição, próximo lance) vira uma entrada de peso 1.
+ * Usado por "maze gerarlivro" (make livro).
+ *
+ * @param arquivo_texto Arquivo no formato de aberturas.txt
+ * @param arquivo_binario Livro .bin a gerar
+ * @return 0 em caso de sucesso, 1 em caso de erro
  */
-int esta_em_livro(int historico_lances[], int num_lances_jogados);
+int gerar_livro_binario(const char *arquivo_texto, const char *arquivo_binario);
 
 /**
- * @brief Obtém o número do lance atual baseado no FEN
- * 
- * Extrai o número do lance do FEN da posição atual.
- * Formato FEN: "... w KQkq - 0 5" -> lance 5
- * 
- * @return Número do lance atual (1, 2, 3, ...)
+ * @brief Confere que ordens de lances diferentes chegam à mesma entrada do livro
+ *
+ * Joga pares fixos de caminhos que terminam na mesma posição (inclusive
+ * depois de avanço duplo sem en passant possível e a partir de FEN) e
+ * compara as chaves do livro; com o livro carregado, exige também que a
+ * posição esteja nele. Usado por "maze conferirlivro" (make livro).
+ *
+ * @return Número de pares que falharam
  */
-int obter_numero_lance_atual();
-
-/**
- * @brief Obtém informações detalhadas do lance atual
- * 
- * @param numero_lance Ponteiro para receber o número do lance
- * @param eh_brancas Ponteiro para receber se é vez das brancas (1) ou pretas (0)
- */
-void obter_info_lance_atual(int* numero_lance, int* eh_brancas);
+int conferir_transposicoes_livro();
 
 /**
  * @brief Libera recursos do livro de aberturas
  */
 void finalizar_livro_aberturas();
 
-// =============================================================================
-// FUNÇÕES AUXILIARES
-// =============================================================================
-
-/**
- * @brief Converte lance UCI para formato interno
- * 
- * @param lance_uci String UCI (ex: "e2e4")
- * @return Lance codificado ou 0 se inválido
- */
-int converter_uci_para_interno(const char* lance_uci);
-
-/**
- * @brief Compara histórico com linha do livro
- * 
- * @param historico Array de lances jogados
- * @param num_jogados Número de lances jogados
- * @param linha Linha do livro para comparar
- * @return 1 se corresponde, 0 caso contrário
- */
-int comparar_historico_com_linha(int historico[], int num_jogados, linha_abertura_t* linha);
-
-#endif // ABERTURAS_H
\ No newline at end of file
+#endif // ABERTURAS_H
@@ -158,6 +158,7 @@ void marcarAtaquesDirecionaisComBloqueio(u64 *ataque, int linha, int coluna, int
  * 
  * Preenche tabelas para peões, cavalos, reis e peças deslizantes.
  * Deve ser chamada uma vez durante a inicialização da engine.
+ * Com TABELAS_PRECALCULADAS não faz nada (tabelas em tabelas_geradas.c).
  */
 void inicializarAtaquesPecas();
 
@@ -168,6 +169,15 @@ void inicializarAtaquesPecas();
  */
 void inicializarAtaquesPecasDeslizantes(int peca);
 
+/**
+ * @brief Inicializa as tabelas casas_entre e linha_casas
+ * 
+ * Usadas pelo gerador legal para cravadas e bloqueio de xeques.
+ * Deve ser chamada depois das tabelas de peças deslizantes.
+ * Com TABELAS_PRECALCULADAS não faz nada.
+ */
+void inicializarTabelasAlinhamento();
+
 // =============================================================================
 // GERAÇÃO DE ATAQUES POR TIPO DE PEÇA
 // =============================================================================
@@ -286,78 +296,146 @@ u64 set_occupancy(int index, int qtde_bits, u64 mask);
 /**
  * @brief Verifica se uma casa está sendo atacada por um lado
  * 
+ * @param pos Posição atual
  * @param casa Casa a verificar (0-63)
  * @param lado Lado que pode estar atacando
  * @return 1 se casa está atacada, 0 caso contrário
  */
-int casaEstaAtacada(int casa, int lado);
-
-// =============================================================================
-// GERAÇÃO DE MOVIMENTOS
-// =============================================================================
+int casaEstaAtacada(const posicao_t *pos, int casa, int lado);
 
 /**
- * @brief Gera movimentos de peão branco
+ * @brief Retorna todas as peças de um lado que atacam uma casa
  * 
- * @param origem Casa de origem do peão
- * @param listaLances Lista onde adicionar os lances gerados
+ * A ocupação é recebida como parâmetro para permitir consultas com
+ * peças removidas (ex: o rei ao fugir ao longo da linha de um xeque).
+ * 
+ * @param pos Posição atual
+ * @param casa Casa a verificar (0-63)
+ * @param lado Lado atacante
+ * @param ocupacao Ocupação usada para os ataques das peças deslizantes
+ * @return Bitboard com as peças atacantes
  */
-void gerar_movimentos_peao_branco(int origem, lances *listaLances);
+u64 atacantes_casa(const posicao_t *pos, int casa, int lado, u64 ocupacao);
 
 /**
- * @brief Gera movimentos de peão preto
+ * @brief Static Exchange Evaluation: saldo material da troca iniciada pelo lance
  * 
- * @param origem Casa de origem do peão
- * @param listaLances Lista onde adicionar os lances gerados
+ * Simula as recapturas na casa de destino sempre com o atacante de menor
+ * valor de cada lado. Peças deslizantes escondidas atrás de atacantes que
+ * saem da linha (raios-x) entram na troca. Cada lado pode interromper a
+ * troca quando continuar só perderia material.
+ * 
+ * @param pos Posição atual
+ * @param lance Lance (normalmente uma captura) do lado a jogar
+ * @return Ganho material em centipeões (negativo = troca perdedora)
  */
-void gerar_movimentos_peao_preto(int origem, lances *listaLances);
+int see(const posicao_t *pos, int lance);
+
+// =============================================================================
+// GERAÇÃO DE MOVIMENTOS
+// =============================================================================
 
 /**
- * @brief Gera movimentos de roque para brancas
+ * @brief Gera todos os lances legais para a posição atual
+ * 
+ * Função principal que gera todos os movimentos possíveis
+ * para o lado que deve jogar na posição atual. Xeques, peças
+ * cravadas e a máscara de evasão são calculados uma vez por
+ * posição, de modo que nenhum lance gerado deixa o rei em xeque.
+ * O gerador é especializado em tempo de compilação para cada lado
+ * e tipo de peça, e os peões são gerados em conjunto (set-wise).
  * 
- * @param listaLances Lista onde adicionar os lances de roque
+ * @param pos Posição atual
+ * @param listaLances Lista onde armazenar todos os lances gerados
  */
-void gerar_roque_branco(lances *listaLances);
+void gerar_lances(const posicao_t *pos, lances *listaLances);
 
 /**
- * @brief Gera movimentos de roque para pretas
+ * @brief Gera apenas as capturas para a posição atual
  * 
- * @param listaLances Lista onde adicionar os lances de roque
+ * Usada pela quiescence search. Gera capturas, capturas com promoção
+ * e en passant, restringindo os destinos às casas ocupadas pelo
+ * oponente. Lances quietos nunca são gerados. Assim como em
+ * gerar_lances(), apenas capturas legais são devolvidas.
+ * 
+ * @param pos Posição atual
+ * @param listaLances Lista onde armazenar as capturas geradas
  */
-void gerar_roque_preto(lances *listaLances);
+void gerar_capturas(const posicao_t *pos, lances *listaLances);
 
 /**
- * @brief Gera movimentos para peças grandes (cavalo, bispo, torre, dama, rei)
+ * @brief Gera apenas os lances quietos para a posição atual
+ * 
+ * Complemento de gerar_capturas(): avanços de peão, promoções sem
+ * captura, roques e movimentos para casas vazias. As duas listas
+ * juntas contêm exatamente os lances de gerar_lances(). Usada pelo
+ * seletor de lances da busca, que só gera os quietos quando as
+ * capturas não bastaram para um corte.
  * 
- * @param origem Casa de origem da peça
- * @param lado Lado da peça (branco ou preto)
- * @param tipo_peca Tipo da peça
- * @param listaLances Lista onde adicionar os lances gerados
+ * @param pos Posição atual
+ * @param listaLances Lista onde armazenar os lances quietos gerados
  */
-void gerar_movimentos_pecaGrande(int origem, int lado, int tipo_peca, lances *listaLances);
+void gerar_quietos(const posicao_t *pos, lances *listaLances);
 
 /**
- * @brief Gera todos os lances legais para a posição atual
+ * @brief Verifica se um lance vindo de fora do gerador é legal na posição
  * 
- * Função principal que gera todos os movimentos possíveis
- * para o lado que deve jogar na posição atual.
+ * Lances da tabela de transposição e killer moves foram gerados em outra
+ * posição (ou são de uma colisão de hash) e precisam ser conferidos antes
+ * de serem jogados sem gerar a lista de lances.
  * 
- * @param listaLances Lista onde armazenar todos os lances gerados
+ * @param pos Posição atual
+ * @param lance Lance a verificar (0 é sempre inválido)
+ * @return 1 se o lance seria gerado por gerar_lances(), 0 caso contrário
  */
-void gerar_lances(lances *listaLances);
+int lance_valido(const posicao_t *pos, int lance);
 
 /**
  * @brief Executa um lance no tabuleiro
  * 
  * Aplica um lance ao estado atual do tabuleiro, atualizando
- * todas as estruturas de dados necessárias. Pode ser desfeito
- * posteriormente usando o backup fornecido.
+ * todas as estruturas de dados necessárias. O registro de desfazer
+ * recebe o que for preciso para desfazer_lance() reverter o lance.
+ * O lance deve vir de gerar_lances() ou gerar_capturas(), que só
+ * produzem lances legais: a legalidade não é verificada aqui.
  * 
+ * @param pos Posição atual
  * @param lance Lance a ser executado
  * @param flag Tipo de lance (todos os lances ou apenas capturas)
- * @param backup Estado do jogo para possível desfazer
- * @return 1 se lance foi executado com sucesso, 0 se inválido
+ * @param desfazer Registro preenchido para desfazer o lance
+ * @return 1 se lance foi executado, 0 se não é captura com flag lancesCaptura
+ */
+int fazer_lance(posicao_t *pos, int lance, int flag, registro_desfazer *desfazer);
+
+/**
+ * @brief Desfaz um lance executado por fazer_lance()
+ * 
+ * Reverte os bitboards a partir do próprio lance e restaura roque,
+ * en passant e chave hash a partir do registro de desfazer.
+ * 
+ * @param pos Posição atual
+ * @param lance Lance a ser desfeito (o mesmo passado a fazer_lance)
+ * @param desfazer Registro preenchido por fazer_lance()
+ */
+void desfazer_lance(posicao_t *pos, int lance, registro_desfazer *desfazer);
+
+/**
+ * @brief Passa a vez sem mover peças (lance nulo)
+ * 
+ * Troca o lado a jogar, apaga a casa en passant e atualiza a chave
+ * hash. Usado pela poda do lance nulo; nunca deve ser feito em xeque.
+ * 
+ * @param pos Posição atual
+ * @param desfazer Registro preenchido para desfazer_lance_nulo()
+ */
+void fazer_lance_nulo(posicao_t *pos, registro_desfazer *desfazer);
+
+/**
+ * @brief Desfaz um lance nulo feito por fazer_lance_nulo()
+ * 
+ * @param pos Posição atual
+ * @param desfazer Registro preenchido por fazer_lance_nulo()
  */
-int fazer_lance(int lance, int flag, estado_jogo backup);
+void desfazer_lance_nulo(posicao_t *pos, registro_desfazer *desfazer);
 
 #endif
@@ -0,0 +1,53 @@
+/**
+ * @file bench.h
+ * @brief Benchmark de busca da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este header declara o comando "bench": um conjunto fixo de posições é
+ * buscado até uma profundidade fixa e o total de nós serve de assinatura
+ * da busca. Mudanças só de velocidade não podem alterar essa assinatura.
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+// =============================================================================
+// PARÂMETROS PADRÃO DO BENCH
+// =============================================================================
+
+/**
+ * @brief Profundidade padrão de cada busca do bench
+ */
+#define BENCH_PROFUNDIDADE_PADRAO 6
+
+/**
+ * @brief Número padrão de threads (com mais de uma a assinatura deixa de ser determinística)
+ */
+#define BENCH_THREADS_PADRAO 1
+
+/**
+ * @brief Tamanho padrão da tabela de transposição do bench em MB
+ */
+#define BENCH_HASH_PADRAO_MB 16
+
+// =============================================================================
+// FUNÇÕES DO BENCH
+// =============================================================================
+
+/**
+ * @brief Busca todas as posições do bench e imprime nós, tempo e NPS
+ *
+ * Cada posição começa com tabela de transposição e histórico limpos, sem
+ * limite de tempo, para que o total de nós seja reproduzível. O número de
+ * threads e o tamanho da tabela de transposição são restaurados ao final.
+ * Valores menores que 1 usam o padrão correspondente.
+ *
+ * @param profundidade Profundidade de cada busca
+ * @param threads Número de threads da busca
+ * @param hash_mb Tamanho da tabela de transposição em MB
+ * @return Total de nós buscados (assinatura do bench)
+ */
+long executar_bench(int profundidade, int threads, int hash_mb);
+
+#endif
@@ -14,6 +14,7 @@
 
 #include <stdio.h>
 #include <string.h> // Para memcpy
+#include <stdatomic.h>
 
 // =============================================================================
 // DEFINIÇÕES DE TIPOS
@@ -24,6 +25,19 @@
  */
 #define u64 unsigned long long
 
+/**
+ * @brief Qualificador das tabelas que podem vir pré-calculadas
+ *
+ * Com -DTABELAS_PRECALCULADAS (make tabelas) as tabelas de ataque e as
+ * máscaras da avaliação são dados const de src/tabelas_geradas.c e nada
+ * é calculado na inicialização.
+ */
+#ifdef TABELAS_PRECALCULADAS
+#define TABELA_GERADA const
+#else
+#define TABELA_GERADA
+#endif
+
 // =============================================================================
 // MACROS DE MANIPULAÇÃO DE BITBOARDS
 // =============================================================================
@@ -107,41 +121,11 @@
  */
 extern const char *casa_nome[];
 
-/**
- * @brief Bitboards para cada tipo de peça (12 peças)
- */
-extern u64 bitboards[12];
-
-/**
- * @brief Ocupações do tabuleiro [branco, preto, ambos]
- */
-extern u64 ocupacoes[3];
-
-/**
- * @brief Lado que deve jogar
- */
-extern int lado_a_jogar;
-
-/**
- * @brief Casa en passant disponível
- */
-extern int en_passant;
-
-/**
- * @brief Direitos de roque
- */
-extern int roque;
-
 /**
  * @brief Permissões de roque por casa
  */
 extern int roque_permissoes[64];
 
-/**
- * @brief Contador de nós para perft
- */
-extern long nos;
-
 /**
  * @brief Representação ASCII das peças
  */
@@ -174,17 +158,41 @@ typedef struct {
     int contador;    ///< Contador de lances gerados
 } lances;
 
+/**
+ * @brief Estado completo de uma posição
+ *
+ * Não há tabuleiro global: cada chamador (thread UCI, busca, perft) guarda
+ * a própria posição e a passa explicitamente para geração, execução e
+ * avaliação de lances. Copiar a estrutura salva a posição inteira.
+ */
+typedef struct {
+    u64 bitboards[12];  ///< Bitboards para cada tipo de peça (12 peças)
+    u64 ocupacoes[3];   ///< Ocupações do tabuleiro [branco, preto, ambos]
+    unsigned char peca_na_casa[64]; ///< Mailbox: peça em cada casa (SEM_PECA se vazia), mantido por fazer/desfazer_lance
+    int lado_a_jogar;   ///< Lado que deve jogar
+    int en_passant;     ///< Casa en passant disponível (-999 = nenhuma)
+    int roque;          ///< Direitos de roque (bitfield)
+    u64 hash_chave;     ///< Chave Zobrist da posição (atualizada incrementalmente)
+} posicao_t;
+
+/**
+ * @brief Valor de peca_na_casa[] para casas vazias
+ */
+#define SEM_PECA 12
+
 // Função utilitária
 void printBitboard(u64 bitboard); // Imprime o bitboard que representa o tabuleiro de xadrez
-void printTabuleiro();            // Imprime o tabuleiro a partir do bitboard
-void printCasasAtacadasPeloLado(int lado);
-void parseFEN(char *fen); // Analisador sintático de FEN (Forsyth-Edwards Notation)
+void printTabuleiro(const posicao_t *pos);            // Imprime o tabuleiro a partir do bitboard
+void printCasasAtacadasPeloLado(const posicao_t *pos, int lado);
+void parseFEN(posicao_t *pos, char *fen); // Analisador sintático de FEN (Forsyth-Edwards Notation)
 int contarBits(u64 bitboard); // Conta o número de bits setados no bitboard
 void printLance(int lance); // Imprime um lance codificado
 void printListaLances(lances *listaLances); // Imprime a lista de lances
 void adicionarLance(lances *listaLances, int lance);
-void perft(int profundidade);
-void perft_teste(int profundidade);
+long perft(posicao_t *pos, int profundidade, atomic_int *parar); // Conta as folhas da árvore de lances; para (devolvendo contagem parcial) quando *parar vira 1 (NULL = até o fim)
+long perft_divide(const posicao_t *pos, int profundidade, int num_threads, atomic_int *parar); // Perft com os lances da raiz divididos entre threads; imprime nós por lance, total, tempo e NPS (retorna 0 se interrompido por *parar)
+void perft_teste(posicao_t *pos, int profundidade); // perft_divide() com uma thread
+int perft_suite(const char *arquivo, int profundidade_maxima, int num_threads); // Confere as contagens de um arquivo EPD ("D1 20 ;D2 400"); retorna o número de falhas (-1 se o arquivo não abriu)
 
 // Enumerações para casas e lados
 enum { a1, b1, c1, d1, e1, f1, g1, h1,
@@ -258,34 +266,15 @@ enum { todosLances, lancesCaptura}; // tipos de lances para busca
 
 */
 
-// Estrutura para backup do estado do jogo
-// Como usar: declare na main ou função relevante: estado_jogo backup;
-// salvar estado: SALVAR_ESTADO(backup);
-// restaurar estado: RESTAURAR_ESTADO(backup);
+// Registro mínimo para desfazer um lance (make/unmake)
+// Como usar: registro_desfazer desfazer;
+// if (fazer_lance(pos, lance, todosLances, &desfazer)) { ...; desfazer_lance(pos, lance, &desfazer); }
 typedef struct {
-    u64 bitboards_backup[12];  // Backup dos bitboards das peças
-    u64 ocupacoes_backup[3];   // Backup das ocupações
-    int lado_a_jogar_backup;   // Backup do lado a jogar
-    int en_passant_backup;     // Backup do en passant
-    int roque_backup;          // Backup dos direitos de roque
-} estado_jogo;
-
-// Macros para salvar e restaurar o estado do jogo
-#define SALVAR_ESTADO(backup) do { \
-    memcpy((backup).bitboards_backup, bitboards, sizeof(bitboards)); \
-    memcpy((backup).ocupacoes_backup, ocupacoes, sizeof(ocupacoes)); \
-    (backup).lado_a_jogar_backup = lado_a_jogar; \
-    (backup).en_passant_backup = en_passant; \
-    (backup).roque_backup = roque; \
-} while(0)
-
-#define RESTAURAR_ESTADO(backup) do { \
-    memcpy(bitboards, (backup).bitboards_backup, sizeof(bitboards)); \
-    memcpy(ocupacoes, (backup).ocupacoes_backup, sizeof(ocupacoes)); \
-    lado_a_jogar = (backup).lado_a_jogar_backup; \
-    en_passant = (backup).en_passant_backup; \
-    roque = (backup).roque_backup; \
-} while(0)
+    int peca_capturada;        // Peça capturada pelo lance (-1 se nenhuma)
+    int roque;                 // Direitos de roque antes do lance
+    int en_passant;            // Casa en passant antes do lance
+    u64 hash;                  // Chave Zobrist antes do lance
+} registro_desfazer;
 
 // Macro para espelhar casa (converter perspectiva branca/preta)
 // Usa XOR com 56 para espelhar: a1(0) <-> a8(56), b1(1) <-> b8(57), etc.
@@ -65,27 +65,27 @@ extern int king_table_eg[64];
 /**
  * @brief Máscaras para colunas do tabuleiro
  */
-extern u64 coluna_masks[64];
+extern TABELA_GERADA u64 coluna_masks[64];
 
 /**
  * @brief Máscaras para linhas do tabuleiro
  */
-extern u64 linha_masks[64];
+extern TABELA_GERADA u64 linha_masks[64];
 
 /**
  * @brief Máscaras para detecção de peões isolados
  */
-extern u64 peao_isolado_masks[64];
+extern TABELA_GERADA u64 peao_isolado_masks[64];
 
 /**
  * @brief Máscaras para detecção de peões passados brancos
  */
-extern u64 peao_passado_branco_masks[64];
+extern TABELA_GERADA u64 peao_passado_branco_masks[64];
 
 /**
  * @brief Máscaras para detecção de peões passados pretos
  */
-extern u64 peao_passado_preto_masks[64];
+extern TABELA_GERADA u64 peao_passado_preto_masks[64];
 
 /**
  * @brief Array para conversão de casa para linha
@@ -215,6 +215,7 @@ u64 set_passed_pawn_mask_black(int file, int rank);
  * 
  * Deve ser chamada uma vez durante a inicialização da engine
  * para preencher todas as máscaras de avaliação.
+ * Com TABELAS_PRECALCULADAS não faz nada.
  */
 void init_evaluation_masks();
 
@@ -225,43 +226,48 @@ void init_evaluation_masks();
 /**
  * @brief Avalia vantagem material
  * 
+ * @param pos Posição atual
  * @return Pontuação baseada na diferença de material
  */
-int evaluate_material();
+int evaluate_material(const posicao_t *pos);
 
 /**
  * @brief Avalia fatores posicionais
  * 
  * Inclui tabelas posicionais para cada tipo de peça.
  * 
+ * @param pos Posição atual
  * @return Pontuação posicional
  */
-int evaluate_positional();
+int evaluate_positional(const posicao_t *pos);
 
 /**
  * @brief Avalia estrutura de peões
  * 
  * Considera peões isolados, dobrados, passados e conectados.
  * 
+ * @param pos Posição atual
  * @return Pontuação da estrutura de peões
  */
-int evaluate_pawn_structure();
+int evaluate_pawn_structure(const posicao_t *pos);
 
 /**
  * @brief Avalia controle de colunas abertas
  * 
+ * @param pos Posição atual
  * @return Pontuação baseada em colunas livres e semi-livres
  */
-int evaluate_open_files();
+int evaluate_open_files(const posicao_t *pos);
 
 /**
  * @brief Avalia mobilidade das peças
  * 
  * Conta movimentos legais disponíveis para cada peça.
  * 
+ * @param pos Posição atual
  * @return Pontuação de mobilidade
  */
-int evaluate_mobility();
+int evaluate_mobility(const posicao_t *pos);
 
 /**
  * @brief Avalia segurança do rei
@@ -269,9 +275,10 @@ int evaluate_mobility();
  * Considera proteção por peões, colunas abertas próximas
  * e casas atacadas ao redor do rei.
  * 
+ * @param pos Posição atual
  * @return Pontuação de segurança do rei
  */
-int evaluate_king_safety();
+int evaluate_king_safety(const posicao_t *pos);
 
 // =============================================================================
 // FUNÇÃO PRINCIPAL DE AVALIAÇÃO
@@ -284,8 +291,9 @@ int evaluate_king_safety();
  * estrutura de peões, mobilidade, segurança do rei) em uma
  * pontuação final da perspectiva do lado que deve jogar.
  * 
+ * @param pos Posição atual
  * @return Avaliação da posição em centipawns
  */
-int evaluate();
+int evaluate(const posicao_t *pos);
 
 #endif
\ No newline at end of file
@@ -33,21 +33,6 @@ extern u64 historico_posicoes[MAX_HISTORIA];
  */
 extern int contador_historia;
 
-/**
- * @brief Tamanho máximo do histórico de lances da partida
- */
-#define MAX_LANCES_PARTIDA 200
-
-/**
- * @brief Histórico de lances para integração com livro de aberturas
- */
-extern int historico_lances_partida[MAX_LANCES_PARTIDA];
-
-/**
- * @brief Número de lances jogados na partida atual
- */
-extern int num_lances_partida;
-
 // =============================================================================
 // FUNÇÕES DE DETECÇÃO DE REPETIÇÃO
 // =============================================================================
@@ -57,27 +42,66 @@ extern int num_lances_partida;
  * 
  * Calcula o hash da posição atual e armazena no histórico
  * para futura detecção de repetições.
+ * 
+ * @param pos Posição atual
  */
-void adicionar_posicao_historia();
+void adicionar_posicao_historia(const posicao_t *pos);
 
 /**
  * @brief Verifica se a posição atual é repetição
  * 
+ * @param pos Posição atual
  * @return 1 se posição foi repetida, 0 caso contrário
  */
-int posicao_repetida();
+int posicao_repetida(const posicao_t *pos);
 
 /**
  * @brief Limpa todo o histórico de posições
  */
 void limpar_historia();
 
+// =============================================================================
+// CHAVES ZOBRIST
+// =============================================================================
+
 /**
- * @brief Calcula hash simples da posição atual
+ * @brief Chaves Zobrist para cada peça em cada casa [peça][casa]
+ */
+extern u64 chaves_pecas[12][64];
+
+/**
+ * @brief Chaves Zobrist para a coluna da casa en passant
+ */
+extern u64 chaves_en_passant[8];
+
+/**
+ * @brief Chaves Zobrist para cada combinação de direitos de roque
+ */
+extern u64 chaves_roque[16];
+
+/**
+ * @brief Chave Zobrist aplicada quando as pretas jogam
+ */
+extern u64 chave_lado;
+
+/**
+ * @brief Inicializa as chaves Zobrist com números pseudo-aleatórios
  * 
- * @return Hash da posição para detecção de repetição
+ * Deve ser chamada uma vez durante a inicialização da engine,
+ * antes de qualquer parseFEN().
  */
-u64 hash_posicao_simples();
+void inicializar_chaves_hash();
+
+/**
+ * @brief Calcula do zero a chave Zobrist da posição atual
+ * 
+ * Usada ao carregar uma posição; durante a busca a chave é mantida
+ * incrementalmente por fazer_lance() na variável hash_chave.
+ * 
+ * @param pos Posição atual
+ * @return Chave Zobrist da posição
+ */
+u64 gerar_chave_hash(const posicao_t *pos);
 
 // =============================================================================
 // TABELAS DE ATAQUES PRÉ-CALCULADAS
@@ -86,37 +110,65 @@ u64 hash_posicao_simples();
 /**
  * @brief Tabela de ataques de peões [lado][casa]
  */
-extern u64 tabela_ataques_peao[2][64];
+extern TABELA_GERADA u64 tabela_ataques_peao[2][64];
 
 /**
  * @brief Tabela de ataques de cavalos por casa
  */
-extern u64 tabela_ataques_cavalo[64];
+extern TABELA_GERADA u64 tabela_ataques_cavalo[64];
 
 /**
  * @brief Tabela de ataques de reis por casa
  */
-extern u64 tabela_ataques_rei[64];
+extern TABELA_GERADA u64 tabela_ataques_rei[64];
 
 /**
  * @brief Máscaras de ataques para bispos (sem bloqueios)
  */
-extern u64 mask_tabela_ataques_bispo[64];
+extern TABELA_GERADA u64 mask_tabela_ataques_bispo[64];
 
 /**
  * @brief Máscaras de ataques para torres (sem bloqueios)
  */
-extern u64 mask_tabela_ataques_torre[64];
+extern TABELA_GERADA u64 mask_tabela_ataques_torre[64];
+
+/**
+ * @brief Soma de 2^bits_relevantes_bispo[casa] nas 64 casas
+ */
+#define TAMANHO_ATAQUES_BISPO 5248
+
+/**
+ * @brief Soma de 2^bits_relevantes_torre[casa] nas 64 casas
+ */
+#define TAMANHO_ATAQUES_TORRE 102400
+
+/**
+ * @brief Tabela única, alinhada a 64 bytes, com os ataques de bispos e depois os de torres
+ *
+ * Cada casa ocupa 2^bits_relevantes entradas consecutivas (compactação
+ * "fancy magic"): cerca de 41 KB para bispos e 800 KB para torres.
+ */
+extern TABELA_GERADA u64 tabela_ataques_deslizantes[TAMANHO_ATAQUES_BISPO + TAMANHO_ATAQUES_TORRE];
 
 /**
- * @brief Tabela completa de ataques de bispos [casa][índice_ocupação]
+ * @brief Trecho de cada casa em tabela_ataques_deslizantes para bispos (indexado pelo índice mágico)
  */
-extern u64 tabela_ataques_bispo[64][512];
+extern TABELA_GERADA u64 *TABELA_GERADA ataques_bispo[64];
 
 /**
- * @brief Tabela completa de ataques de torres [casa][índice_ocupação]
+ * @brief Trecho de cada casa em tabela_ataques_deslizantes para torres (indexado pelo índice mágico)
  */
-extern u64 tabela_ataques_torre[64][4096];
+extern TABELA_GERADA u64 *TABELA_GERADA ataques_torre[64];
+
+/**
+ * @brief Casas estritamente entre duas casas alinhadas [casa][casa] (0 se não alinhadas)
+ */
+extern TABELA_GERADA u64 casas_entre[64][64];
+
+/**
+ * @brief Linha, coluna ou diagonal completa que passa por duas casas [casa][casa] (0 se não alinhadas)
+ */
+extern TABELA_GERADA u64 linha_casas[64][64];
 
 // =============================================================================
 // MAGIC BITBOARDS - DADOS PRÉ-CALCULADOS
@@ -142,13 +194,4 @@ extern u64 magics_bispo[64];
  */
 extern u64 magics_torre[64];
 
-// =============================================================================
-// ESTADO DO JOGO
-// =============================================================================
-
-/**
- * @brief Variável global para backup do estado do jogo
- */
-extern estado_jogo backup_global;
-
 #endif
\ No newline at end of file
@@ -13,30 +13,88 @@
 #define SEARCH_H
 
 #include "bitboard.h"
+#include "tempo.h"
 
 // =============================================================================
-// VARIÁVEIS GLOBAIS DE BUSCA
+// CONSTANTES E VARIÁVEIS GLOBAIS DE BUSCA
 // =============================================================================
 
 /**
- * @brief Profundidade atual da busca (ply)
+ * @brief Máxima profundidade de busca para arrays estáticos
  */
-extern int ply;
+#define MAX_PLY_BUSCA 64
 
 /**
- * @brief Melhor lance encontrado na busca
+ * @brief Score de mate (mate no ply N vale -VALOR_MATE + N)
  */
-extern int bestMove;
+#define VALOR_MATE 99999
 
 /**
- * @brief Máxima profundidade de busca para arrays estáticos
+ * @brief Scores com módulo acima deste limite representam mate
  */
-#define MAX_PLY_BUSCA 64
+#define LIMITE_MATE (VALOR_MATE - MAX_PLY_BUSCA)
+
+/**
+ * @brief Meia-largura inicial da janela de aspiração (centipeões)
+ */
+#define JANELA_ASPIRACAO 100
+
+/**
+ * @brief Profundidade a partir da qual a raiz usa janela de aspiração
+ */
+#define PROFUNDIDADE_MINIMA_ASPIRACAO 4
+
+/**
+ * @brief Profundidade mínima para tentar o lance nulo
+ */
+#define PROFUNDIDADE_MINIMA_NULO 3
+
+/**
+ * @brief Redução do lance nulo (mais 1 a partir de PROFUNDIDADE_REDUCAO_NULO_EXTRA)
+ */
+#define REDUCAO_NULO 2
+
+/**
+ * @brief Profundidade a partir da qual a redução do lance nulo aumenta
+ */
+#define PROFUNDIDADE_REDUCAO_NULO_EXTRA 7
+
+/**
+ * @brief Profundidade a partir da qual um corte por lance nulo é verificado
+ */
+#define PROFUNDIDADE_VERIFICACAO_NULO 6
+
+/**
+ * @brief Profundidade mínima para reduzir lances tardios (LMR)
+ */
+#define PROFUNDIDADE_MINIMA_LMR 3
+
+/**
+ * @brief Quantos lances de cada nó são sempre buscados sem redução
+ */
+#define LANCES_SEM_REDUCAO 3
 
 /**
- * @brief Array para detectar repetição na linha de busca atual
+ * @brief Número de colunas da tabela de reduções (lances além disso usam a última)
  */
-extern u64 hash_linha_busca[MAX_PLY_BUSCA];
+#define MAX_LANCES_REDUCAO 64
+
+/**
+ * @brief Valor máximo da tabela de histórico (acima disso ela é dividida por 2)
+ */
+#define MAX_HISTORICO 16384
+
+/**
+ * @brief Número máximo de threads de busca (setoption Threads)
+ */
+#define MAX_THREADS_BUSCA 256
+
+/**
+ * @brief Tamanho da pilha de cada thread de busca
+ *
+ * A recursão do negamax guarda listas de lances na pilha.
+ */
+#define TAMANHO_PILHA_BUSCA (16 * 1024 * 1024)
 
 /**
  * @brief Tabela MVV-LVA para ordenação de capturas
@@ -46,29 +104,82 @@ extern u64 hash_linha_busca[MAX_PLY_BUSCA];
  */
 extern int mvv_lva[12][12];
 
+// =============================================================================
+// CONTEXTO DE BUSCA
+// =============================================================================
+
+/**
+ * @brief Contexto de uma thread de busca: posição e pilha de busca próprias
+ *
+ * Todas as funções de busca recebem o contexto explicitamente. Os contextos,
+ * o relógio e o sinal de parada pertencem a quem chama busca_lance(), então
+ * buscas independentes podem rodar ao mesmo tempo desde que cada uma use os
+ * seus. Só a tabela de transposição é compartilhada entre elas.
+ */
+typedef struct {
+    posicao_t pos;                                      ///< Posição sendo buscada
+    long nos;                                           ///< Nós visitados
+    int ply;                                            ///< Distância até a raiz
+    u64 hash_linha_busca[MAX_PLY_BUSCA];                ///< Chaves da linha atual (repetição)
+    int killer_moves[2][MAX_PLY_BUSCA];                 ///< Killer moves [índice][ply]
+    int history_moves[12][64];                          ///< History moves [peça][casa]
+    int pv_length[MAX_PLY_BUSCA];                       ///< Comprimento da PV em cada ply
+    int pv_table[MAX_PLY_BUSCA][MAX_PLY_BUSCA];         ///< Tabela triangular da PV
+    int follow_pv;                                      ///< Seguindo a PV da iteração anterior
+    int lance_nulo[MAX_PLY_BUSCA];                      ///< 1 se o lance feito neste ply foi nulo
+    int verificando_nulo;                               ///< Dentro de uma busca de verificação (sem lance nulo)
+    controle_tempo_t *controle;                         ///< Relógio e sinal de parada da busca (do chamador)
+} motor_t;
+
+// =============================================================================
+// SELETOR DE LANCES
+// =============================================================================
+
 /**
- * @brief Tabela de killer moves [índice][profundidade]
+ * @brief Estágios do seletor de lances, na ordem em que são percorridos
  */
-extern int killer_moves[2][64];
+enum {
+    ESTAGIO_HASH,           ///< Lance da tabela de transposição e da PV, sem gerar nada
+    ESTAGIO_GERAR_CAPTURAS, ///< Gera e pontua as capturas (MVV-LVA)
+    ESTAGIO_CAPTURAS_BOAS,  ///< Capturas por seleção; as perdedoras são guardadas
+    ESTAGIO_KILLERS,        ///< Killer moves do ply, se forem válidos na posição
+    ESTAGIO_GERAR_QUIETOS,  ///< Gera e pontua os lances quietos (histórico; promoção a dama antes, subpromoções por último)
+    ESTAGIO_QUIETOS,        ///< Lances quietos por seleção
+    ESTAGIO_CAPTURAS_RUINS, ///< Capturas com SEE negativa
+    ESTAGIO_FIM
+};
 
 /**
- * @brief Tabela de history moves [peça][casa]
+ * @brief Estado do seletor de lances de um nó
+ *
+ * As capturas perdedoras ficam no início da lista, em casas já consumidas;
+ * os lances quietos são gerados logo depois delas.
  */
-extern int history_moves[12][64];
+typedef struct {
+    int estagio;            ///< Estágio atual
+    int somente_capturas;   ///< 1 na quiescence: termina depois das capturas boas
+    int prioritarios[2];    ///< Lance da tabela de transposição e lance da PV
+    int killers[2];         ///< Killer moves já devolvidos
+    int indice;             ///< Próxima posição da lista a examinar
+    int num_ruins;          ///< Capturas perdedoras guardadas em lista[0..num_ruins)
+    lances lista;           ///< Capturas e depois lances quietos
+    int scores[256];        ///< Pontuação de cada lance da lista
+} seletor_lances;
 
 // =============================================================================
 // FUNÇÕES DE VARIAÇÃO PRINCIPAL (PV)
 // =============================================================================
 
 /**
- * @brief Habilita pontuação para seguir a variação principal
+ * @brief Lance da variação principal a ser buscado primeiro neste ply
  * 
- * Configura flags para dar prioridade aos lances da linha
- * principal durante a busca.
+ * Se o lance da PV da iteração anterior não for válido na posição, a
+ * linha acabou e follow_pv é desligado.
  * 
- * @param listaLances Lista de lances a verificar
+ * @param motor Contexto da busca (com follow_pv ligado)
+ * @return Lance da PV, ou 0 se a busca saiu da linha principal
  */
-void enable_pv_scoring(lances *listaLances);
+int enable_pv_scoring(motor_t *motor);
 
 // =============================================================================
 // ALGORITMOS DE BUSCA
@@ -80,11 +191,20 @@ void enable_pv_scoring(lances *listaLances);
  * Estende a busca apenas para capturas para evitar o
  * "horizon effect" e melhorar a avaliação de posições táticas.
  * 
+ * @param motor Contexto da busca
  * @param alpha Valor alfa para poda alfa-beta
  * @param beta Valor beta para poda alfa-beta
  * @return Avaliação da posição após capturas forçadas
  */
-int quiescence(int alpha, int beta);
+int quiescence(motor_t *motor, int alpha, int beta);
+
+/**
+ * @brief Preenche a tabela de reduções do LMR
+ * 
+ * redução = 0.75 + ln(profundidade) * ln(número do lance) / 2.25.
+ * Deve ser chamada uma vez durante a inicialização da engine.
+ */
+void inicializar_reducoes();
 
 /**
  * @brief Algoritmo principal de busca Negamax com poda alfa-beta
@@ -94,24 +214,41 @@ int quiescence(int alpha, int beta);
  * - Variação principal (PV)
  * - Killer moves
  * - History heuristic
+ * - Poda do lance nulo
+ * - Redução de lances tardios (LMR) com nova busca em caso de falha alta
  * - Quiescence search
  * 
+ * @param motor Contexto da busca
  * @param alpha Valor alfa para poda alfa-beta
  * @param beta Valor beta para poda alfa-beta
  * @param depth Profundidade restante de busca
  * @return Avaliação da posição
  */
-int negamax(int alpha, int beta, int depth);
+int negamax(motor_t *motor, int alpha, int beta, int depth);
 
 /**
  * @brief Função principal de busca iterativa
  * 
  * Executa busca com profundidade crescente (iterative deepening)
  * até a profundidade especificada, atualizando o melhor lance.
+ * A partir de PROFUNDIDADE_MINIMA_ASPIRACAO, cada iteração começa com uma
+ * janela de aspiração em torno do score da anterior, alargada a cada
+ * falha alta ou baixa.
+ * Com num_threads > 1, inicia threads auxiliares (Lazy SMP) que buscam
+ * a mesma posição com cópias próprias do tabuleiro e compartilham apenas a
+ * tabela de transposição; apenas a thread principal imprime informações.
+ * Respeita o controle configurado por init_tempo(): uma iteração
+ * interrompida é descartada e o lance devolvido é sempre o da última
+ * iteração completa. Ao terminar, deixa controle->parar em 1.
  * 
+ * @param motores Contextos das threads (num_threads entradas, do chamador)
+ * @param num_threads Número de threads (1 = sem Lazy SMP)
+ * @param controle Relógio e sinal de parada desta busca (do chamador)
+ * @param pos Posição a ser buscada (não é alterada)
  * @param depth Profundidade máxima de busca
+ * @return Total de nós buscados (todas as threads)
  */
-void busca_lance(int depth);
+long busca_lance(motor_t motores[], int num_threads, controle_tempo_t *controle, const posicao_t *pos, int depth);
 
 // =============================================================================
 // ORDENAÇÃO E PONTUAÇÃO DE LANCES
@@ -130,71 +267,30 @@ void busca_lance(int depth);
 int get_mvv_lva_score(int atacante, int vitima);
 
 /**
- * @brief Calcula pontuação de um lance para ordenação
+ * @brief Prepara o seletor de lances de um nó
  * 
- * Atribui pontuação baseada em:
- * - Variação principal
- * - Capturas (MVV-LVA)
- * - Killer moves
- * - History heuristic
+ * Nada é gerado aqui: o lance da tabela de transposição e o da PV só são
+ * conferidos com lance_valido(), e as listas são geradas pelo próprio
+ * seletor quando os estágios anteriores não produziram um corte.
  * 
- * @param move Lance a ser pontuado
- * @return Pontuação do lance
+ * @param seletor Seletor a inicializar
+ * @param motor Contexto da busca
+ * @param lance_hash Melhor lance da tabela de transposição (0 se nenhum)
+ * @param somente_capturas 1 na quiescence (só capturas que não perdem material)
  */
-int score_move(int move);
+void iniciar_seletor(seletor_lances *seletor, motor_t *motor, int lance_hash, int somente_capturas);
 
 /**
- * @brief Ordena lista de lances por pontuação
+ * @brief Devolve o próximo lance a buscar
  * 
- * Ordena lances em ordem decrescente de pontuação para
- * melhorar eficiência da poda alfa-beta.
- * 
- * @param listaLances Lista de lances a ordenar
- * @return Sempre retorna 0 (compatibilidade)
- */
-int sort_moves(lances *listaLances);
-
-/**
- * @brief Imprime pontuações dos lances (debug)
- * 
- * Função auxiliar para depuração que mostra as pontuações
- * atribuídas aos lances pela função de ordenação.
- */
-void print_move_scores();
-
-// =============================================================================
-// FUNÇÕES AUXILIARES DE ORDENAÇÃO
-// =============================================================================
-
-/**
- * @brief Troca dois lances na lista
- * 
- * @param listaLances Lista de lances
- * @param move_scores Array de pontuações
- * @param i Índice do primeiro lance
- * @param j Índice do segundo lance
- */
-void swap_moves(lances *listaLances, int *move_scores, int i, int j);
-
-/**
- * @brief Função de partição para quicksort
- * 
- * @param listaLances Lista de lances
- * @param move_scores Array de pontuações
- * @param low Índice inferior
- * @param high Índice superior
- * @return Índice do pivô após partição
- */
-int partition(lances *listaLances, int *move_scores, int low, int high);
-
-/**
- * @brief Algoritmo quicksort para ordenação de lances
+ * Ordem: lance da tabela de transposição, lance da PV, capturas boas por
+ * MVV-LVA, killer moves, lances quietos por histórico e, por último, as
+ * capturas perdedoras. Cada lance legal é devolvido uma única vez.
  * 
- * @param listaLances Lista de lances
- * @param move_scores Array de pontuações
- * @param low Índice inferior
- * @param high Índice superior
+ * @param seletor Seletor do nó
+ * @param motor Contexto da busca
+ * @return Próximo lance legal, ou 0 quando não há mais lances
  */
-void quicksort_moves(lances *listaLances, int *move_scores, int low, int high);
+int proximo_lance(seletor_lances *seletor, motor_t *motor);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,34 @@
+/**
+ * @file tabelas.h
+ * @brief Exportação das tabelas pré-calculadas da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este header declara o gerador usado por "make tabelas": depois de
+ * runEngine() as tabelas de ataque e as máscaras da avaliação são escritas
+ * como dados const em um arquivo .c. Compilado com -DTABELAS_PRECALCULADAS,
+ * esse arquivo substitui todo o cálculo da inicialização e as tabelas ficam
+ * em páginas somente leitura do executável.
+ */
+
+#ifndef TABELAS_H
+#define TABELAS_H
+
+// =============================================================================
+// EXPORTAÇÃO DAS TABELAS
+// =============================================================================
+
+/**
+ * @brief Escreve as tabelas de ataque e as máscaras da avaliação como código C
+ *
+ * O arquivo gerado define tudo o que inicializarAtaquesPecas(),
+ * inicializarTabelasAlinhamento() e init_evaluation_masks() calculam.
+ * As tabelas de bispos e torres dependem do backend (magic ou PEXT): o
+ * arquivo só compila com o mesmo backend do executável que o gerou.
+ *
+ * @param arquivo Caminho do arquivo .c a gerar
+ * @return 0 em caso de sucesso, 1 se o arquivo não pôde ser escrito
+ */
+int exportar_tabelas(const char *arquivo);
+
+#endif
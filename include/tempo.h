@@ -0,0 +1,130 @@
+/**
+ * @file tempo.h
+ * @brief Controle de tempo da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este header declara o gerenciador de tempo usado pela busca. A partir dos
+ * parâmetros do comando "go" (wtime/btime/winc/binc/movestogo/movetime) são
+ * calculados dois limites:
+ * - Limite suave: depois dele nenhuma nova iteração é iniciada
+ * - Limite rígido: a busca em andamento é interrompida
+ */
+
+#ifndef TEMPO_H
+#define TEMPO_H
+
+#include <stdatomic.h>
+
+// =============================================================================
+// CONSTANTES DO CONTROLE DE TEMPO
+// =============================================================================
+
+/**
+ * @brief De quantos em quantos nós o relógio é consultado durante a busca
+ */
+#define INTERVALO_VERIFICACAO_TEMPO 2048
+
+/**
+ * @brief Margem de segurança (ms) para latência de comunicação com a GUI
+ */
+#define MARGEM_TEMPO 50
+
+/**
+ * @brief Número de lances assumido até o próximo controle quando não informado
+ */
+#define LANCES_ATE_CONTROLE_PADRAO 30
+
+// =============================================================================
+// ESTRUTURAS DE DADOS
+// =============================================================================
+
+/**
+ * @brief Estado do controle de tempo e sinal de parada de uma busca
+ *
+ * Pertence a quem chama busca_lance(): a thread UCI mantém o seu e o bench
+ * o dele, então buscas diferentes não param umas às outras.
+ */
+typedef struct {
+    int ativo;          ///< 1 se a busca tem limite de tempo
+    int inicio;         ///< Instante de início da busca (ms)
+    int limite_suave;   ///< Tempo (ms desde o início) após o qual não se inicia nova iteração
+    int limite_rigido;  ///< Tempo (ms desde o início) após o qual a busca é interrompida
+    int pode_parar;     ///< 1 quando já existe uma iteração completa para devolver
+    int infinito;       ///< 1 em "go infinite": bestmove só depois de "stop"
+    atomic_int ponder;  ///< 1 em "go ponder" até chegar "ponderhit" ou "stop"
+    atomic_int parar;   ///< Pede que a busca seja interrompida o quanto antes ("stop", "quit" ou limite rígido)
+} controle_tempo_t;
+
+// =============================================================================
+// FUNÇÕES DE CONTROLE DE TEMPO
+// =============================================================================
+
+/**
+ * @brief Configura o controle de tempo para uma nova busca
+ *
+ * Com movetime > 0, os dois limites são o próprio movetime (menos a margem).
+ * Com tempo_restante > 0, o tempo é dividido pelos lances até o controle e
+ * somado a parte do incremento; o limite rígido permite estourar essa fatia
+ * em lances difíceis, mas nunca passa do tempo restante.
+ * Sem nenhum dos dois, a busca fica sem limite de tempo. Também limpa o
+ * sinal de parada.
+ *
+ * @param controle Controle a configurar
+ * @param tempo_restante Tempo no relógio do lado a jogar (ms, -1 se ausente)
+ * @param incremento Incremento por lance do lado a jogar (ms)
+ * @param movestogo Lances até o próximo controle (0 se ausente)
+ * @param movetime Tempo fixo para o lance (ms, -1 se ausente)
+ * @param infinito 1 para "go infinite"
+ * @param ponder 1 para "go ponder" (limites só valem após "ponderhit")
+ */
+void init_tempo(controle_tempo_t *controle, int tempo_restante, int incremento, int movestogo, int movetime, int infinito, int ponder);
+
+/**
+ * @brief Trata o comando "ponderhit"
+ *
+ * O adversário jogou o lance esperado: a busca continua, agora sujeita aos
+ * limites calculados em init_tempo(), contados a partir deste instante.
+ *
+ * @param controle Controle da busca em ponder
+ */
+void tempo_ponderhit(controle_tempo_t *controle);
+
+/**
+ * @brief Indica se o bestmove deve esperar por "stop" ou "ponderhit"
+ *
+ * @param controle Controle da busca
+ * @return 1 em busca infinita ou ponder ainda não confirmado
+ */
+int aguardando_stop(const controle_tempo_t *controle);
+
+/**
+ * @brief Tempo decorrido desde o início da busca
+ *
+ * @param controle Controle da busca
+ * @return Tempo em milissegundos
+ */
+int tempo_decorrido(const controle_tempo_t *controle);
+
+/**
+ * @brief Consulta o relógio e sinaliza a parada se o limite rígido passou
+ *
+ * Chamada a cada INTERVALO_VERIFICACAO_TEMPO nós por negamax() e quiescence().
+ *
+ * @param controle Controle da busca
+ */
+void verificar_tempo(controle_tempo_t *controle);
+
+/**
+ * @brief Decide se vale a pena iniciar a próxima iteração
+ *
+ * A próxima iteração costuma custar algumas vezes a anterior; se ela não
+ * deve terminar antes do limite rígido, é melhor parar com o resultado atual.
+ *
+ * @param controle Controle da busca
+ * @param tempo_ultima_iteracao Duração da última iteração completa (ms)
+ * @return 1 se a próxima iteração deve ser iniciada, 0 caso contrário
+ */
+int iniciar_proxima_iteracao(const controle_tempo_t *controle, int tempo_ultima_iteracao);
+
+#endif
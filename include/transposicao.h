@@ -0,0 +1,204 @@
+/**
+ * @file transposicao.h
+ * @brief Tabela de transposição da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este header declara a tabela de transposição (hash table) usada pela busca
+ * para reaproveitar resultados de posições já analisadas. A tabela tem tamanho
+ * fixo, é organizada em buckets do tamanho de uma linha de cache e guarda
+ * profundidade, tipo de limite, score e melhor lance de cada posição.
+ * Uma segunda tabela, opcional, guarda contagens de subárvores do perft.
+ */
+
+#ifndef TRANSPOSICAO_H
+#define TRANSPOSICAO_H
+
+#include "bitboard.h"
+
+// =============================================================================
+// CONSTANTES DA TABELA DE TRANSPOSIÇÃO
+// =============================================================================
+
+/**
+ * @brief Tamanho padrão da tabela de transposição em MB
+ */
+#define TT_TAMANHO_PADRAO_MB 64
+
+/**
+ * @brief Tamanho máximo aceito para a tabela de transposição em MB
+ */
+#define TT_TAMANHO_MAXIMO_MB 4096
+
+/**
+ * @brief Tamanho padrão da tabela do perft em MB (0 = desligada)
+ *
+ * Desligada por padrão para que o perft meça o gerador de lances; ligada
+ * com "setoption name PerftHash value <MB>".
+ */
+#define TT_PERFT_TAMANHO_PADRAO_MB 0
+
+/**
+ * @brief Número de entradas por bucket (4 x 16 bytes = 64 bytes = 1 linha de cache)
+ */
+#define TT_ENTRADAS_POR_BUCKET 4
+
+/**
+ * @brief Valor retornado pela sondagem quando a entrada não serve para corte
+ */
+#define SEM_ENTRADA_HASH 100000
+
+/**
+ * @brief Tipos de limite armazenados na tabela (0 indica entrada vazia)
+ *
+ * hash_exato: score exato (alpha < score < beta)
+ * hash_alfa:  limite superior (nenhum lance superou alpha)
+ * hash_beta:  limite inferior (houve corte beta)
+ */
+enum { hash_exato = 1, hash_alfa, hash_beta };
+
+// =============================================================================
+// ESTRUTURAS DE DADOS
+// =============================================================================
+
+/**
+ * @brief Entrada da tabela de transposição (16 bytes)
+ *
+ * A parte baixa da chave é usada como índice do bucket, então apenas
+ * os 32 bits superiores são guardados para verificação.
+ *
+ * A tabela é compartilhada entre as threads sem travas. Para que uma entrada
+ * escrita pela metade por outra thread não seja aceita, a verificação é
+ * gravada combinada (XOR) com os demais campos: se qualquer campo não
+ * corresponder à mesma escrita, a verificação falha.
+ */
+typedef struct {
+    unsigned int verificacao;   ///< 32 bits superiores da chave XOR os demais campos
+    int lance;                  ///< Melhor lance encontrado (0 = nenhum)
+    int score;                  ///< Score da posição (mates relativos ao nó)
+    unsigned char profundidade; ///< Profundidade restante da busca que gerou a entrada
+    unsigned char flag;         ///< Tipo de limite (hash_exato, hash_alfa, hash_beta)
+    unsigned short geracao;     ///< Geração da busca que gravou a entrada
+} entrada_tt;
+
+/**
+ * @brief Bucket da tabela, alinhado a uma linha de cache
+ */
+typedef struct {
+    entrada_tt entradas[TT_ENTRADAS_POR_BUCKET];
+} __attribute__((aligned(64))) bucket_tt;
+
+/**
+ * @brief Entrada da tabela do perft (16 bytes)
+ *
+ * Guarda o número de folhas de uma subárvore: dados = nós << 8 | profundidade.
+ * Como na tabela da busca, a chave é gravada em XOR com os dados para que
+ * escritas concorrentes pela metade sejam descartadas.
+ */
+typedef struct {
+    u64 verificacao;    ///< Chave Zobrist XOR dados
+    u64 dados;          ///< Nós da subárvore (56 bits) e profundidade restante (8 bits)
+} entrada_tt_perft;
+
+// =============================================================================
+// FUNÇÕES DA TABELA DE TRANSPOSIÇÃO
+// =============================================================================
+
+/**
+ * @brief Aloca (ou realoca) a tabela de transposição
+ *
+ * O número de buckets é arredondado para baixo até uma potência de dois,
+ * permitindo indexar com uma máscara em vez de divisão. A memória vem
+ * zerada do calloc, sem percorrer a tabela.
+ *
+ * @param megabytes Tamanho desejado da tabela em MB
+ */
+void inicializar_tt(int megabytes);
+
+/**
+ * @brief Zera todas as entradas da tabela de transposição
+ */
+void limpar_tt();
+
+/**
+ * @brief Libera a memória da tabela de transposição
+ */
+void finalizar_tt();
+
+/**
+ * @brief Tamanho da tabela de transposição pedido em inicializar_tt()
+ *
+ * @return Tamanho em MB
+ */
+int tamanho_tt_mb();
+
+/**
+ * @brief Avança a geração da tabela no início de uma nova busca
+ *
+ * Entradas de buscas anteriores passam a ter prioridade menor
+ * na substituição.
+ */
+void nova_busca_tt();
+
+/**
+ * @brief Consulta a tabela de transposição
+ *
+ * Sempre devolve o melhor lance armazenado (para ordenação), mesmo quando
+ * a entrada não é profunda o suficiente para gerar um corte.
+ *
+ * @param chave Chave hash da posição
+ * @param profundidade Profundidade restante da busca atual
+ * @param alpha Valor alfa atual
+ * @param beta Valor beta atual
+ * @param ply Distância do nó até a raiz (ajuste de scores de mate)
+ * @param lance Ponteiro para receber o lance armazenado (0 se nenhum)
+ * @return Score utilizável para corte ou SEM_ENTRADA_HASH
+ */
+int sondar_tt(u64 chave, int profundidade, int alpha, int beta, int ply, int *lance);
+
+/**
+ * @brief Grava o resultado de uma busca na tabela de transposição
+ *
+ * @param chave Chave hash da posição
+ * @param profundidade Profundidade restante da busca
+ * @param score Score encontrado
+ * @param flag Tipo de limite (hash_exato, hash_alfa, hash_beta)
+ * @param lance Melhor lance encontrado (0 se nenhum)
+ * @param ply Distância do nó até a raiz (ajuste de scores de mate)
+ */
+void gravar_tt(u64 chave, int profundidade, int score, int flag, int lance, int ply);
+
+// =============================================================================
+// TABELA DO PERFT
+// =============================================================================
+
+/**
+ * @brief Aloca (ou realoca) a tabela do perft
+ *
+ * A tabela guarda contagens de subárvores indexadas pela chave Zobrist e
+ * pela profundidade restante, e é compartilhada pelas threads do perft.
+ *
+ * @param megabytes Tamanho desejado em MB (0 desliga a tabela)
+ */
+void inicializar_tt_perft(int megabytes);
+
+/**
+ * @brief Consulta a contagem de folhas de uma subárvore
+ *
+ * @param chave Chave hash da posição
+ * @param profundidade Profundidade restante
+ * @param nos Ponteiro para receber o número de folhas
+ * @return 1 se a contagem estava na tabela, 0 caso contrário
+ */
+int sondar_tt_perft(u64 chave, int profundidade, long *nos);
+
+/**
+ * @brief Grava a contagem de folhas de uma subárvore
+ *
+ * @param chave Chave hash da posição
+ * @param profundidade Profundidade restante
+ * @param nos Número de folhas da subárvore
+ */
+void gravar_tt_perft(u64 chave, int profundidade, long nos);
+
+#endif
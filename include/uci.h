@@ -35,10 +35,11 @@
  * - "e7e8q": Promoção de peão para dama
  * - "e1g1": Roque pequeno do rei branco
  * 
+ * @param pos Posição atual
  * @param string_lance String contendo o lance no formato UCI
  * @return Código do lance no formato interno ou -1 se inválido
  */
-int parse_move(char *string_lance);
+int parse_move(const posicao_t *pos, char *string_lance);
 
 /**
  * @brief Processa comando UCI "position"
@@ -47,9 +48,10 @@ int parse_move(char *string_lance);
  * Suporta tanto "position startpos" quanto "position fen <fen_string>".
  * Também processa a lista de movimentos se fornecida.
  * 
+ * @param pos Posição atual
  * @param string_posicao String completa do comando position
  */
-void parse_position(char *string_posicao);
+void parse_position(posicao_t *pos, char *string_posicao);
 
 /**
  * @brief Processa comando UCI "go"
@@ -63,10 +65,25 @@ void parse_position(char *string_posicao);
  * - nodes: Número máximo de nós a examinar
  * - movetime: Tempo fixo para o lance
  * - infinite: Busca infinita até comando "stop"
+ * - ponder: Busca no tempo do adversário até "ponderhit" ou "stop"
+ * - perft N: Conta as folhas até a profundidade N com as threads
+ *   configuradas em "Threads", imprimindo o total por lance da raiz
  * 
+ * @param pos Posição atual
  * @param string_go String completa do comando go
  */
-void parse_go(char *string_go);
+void parse_go(const posicao_t *pos, char *string_go);
+
+/**
+ * @brief Processa comando UCI "setoption"
+ * 
+ * Opções suportadas:
+ * - Hash: tamanho da tabela de transposição em MB
+ * - Threads: número de threads da busca (Lazy SMP)
+ * 
+ * @param string_opcao String completa do comando setoption
+ */
+void parse_setoption(char *string_opcao);
 
 /**
  * @brief Converte um lance interno para string UCI
@@ -79,6 +96,45 @@ void parse_go(char *string_go);
  */
 void lance_para_uci(int lance, char* buffer);
 
+// =============================================================================
+// CONTROLE DA THREAD DE BUSCA
+// =============================================================================
+
+/**
+ * @brief Inicia a busca em uma thread separada
+ * 
+ * A thread UCI continua lendo comandos enquanto a busca roda, de modo que
+ * "stop", "isready", "ponderhit" e "quit" são atendidos durante a busca.
+ * Uma busca anterior ainda em andamento é interrompida antes.
+ * 
+ * @param pos Posição a ser buscada (copiada para a thread de busca)
+ * @param profundidade Profundidade máxima da busca
+ */
+void iniciar_busca(const posicao_t *pos, int profundidade);
+
+/**
+ * @brief Inicia "go perft" na thread de busca
+ * 
+ * Como na busca, a thread UCI continua atendendo "isready", e "stop" ou
+ * "quit" interrompem a contagem (o resultado parcial não é impresso).
+ * 
+ * @param pos Posição a ser contada (copiada para a thread de busca)
+ * @param profundidade Profundidade do perft
+ */
+void iniciar_perft(const posicao_t *pos, int profundidade);
+
+/**
+ * @brief Espera a busca em andamento terminar sozinha
+ */
+void aguardar_busca();
+
+/**
+ * @brief Sinaliza a parada da busca do loop UCI e espera a thread de busca encerrar
+ * 
+ * A busca interrompida ainda imprime o bestmove da última iteração completa.
+ */
+void interromper_busca();
+
 // =============================================================================
 // FUNÇÃO PRINCIPAL UCI
 // =============================================================================
@@ -91,11 +147,12 @@ void lance_para_uci(int lance, char* buffer);
  * - uci: Identifica o engine
  * - isready: Confirma que engine está pronto
  * - position: Configura posição do tabuleiro
- * - go: Inicia busca
+ * - go: Inicia busca (em segundo plano)
  * - stop: Para busca atual
+ * - ponderhit: Adversário jogou o lance ponderado
  * - quit: Encerra engine
  * 
- * Mantém loop até receber comando "quit".
+ * Mantém loop até receber comando "quit" ou fim da entrada.
  */
 void uci_loop();
 
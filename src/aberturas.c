@@ -1,262 +1,512 @@
 #include "../include/aberturas.h"
+#include "../include/ataques.h"
 #include "../include/uci.h"
 #include "../include/globals.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <ctype.h>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 // Variável global do livro de aberturas
 livro_aberturas_t livro_aberturas = {0};
 
+// Posição de onde partem as linhas de aberturas.txt
+static const char fen_inicial[] = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// =============================================================================
+// FORMATO DAS ENTRADAS (LAYOUT POLYGLOT)
+// =============================================================================
+// bytes 0-7: chave | 8-9: lance | 10-11: peso | 12-15: aprendizado (big-endian)
+
 /**
- * @brief Inicializa o sistema de livro de aberturas
+ * @brief Lê um inteiro big-endian de 1 a 8 bytes
  */
-int inicializar_livro_aberturas() {
-    FILE *arquivo;
-    char linha[512];
-    char nome_abertura_atual[MAX_NOME_ABERTURA] = "Desconhecida";
-    
-    // Inicializar o random seed
-    srand(time(NULL));
-    
-    livro_aberturas.num_linhas = 0;
-    livro_aberturas.inicializado = 0;
-    
-    // Tentar abrir o arquivo de aberturas
-    arquivo = fopen("aberturas.txt", "r");
-    if (arquivo == NULL) {
-        printf("info string Aviso: arquivo aberturas.txt nao encontrado\n");
-        return 0;
+static u64 ler_big_endian(const unsigned char *bytes, int tamanho) {
+    u64 valor = 0;
+    for (int i = 0; i < tamanho; i++) {
+        valor = (valor << 8) | bytes[i];
     }
-    
-    printf("info string Carregando livro de aberturas...\n");
-    
-    while (fgets(linha, sizeof(linha), arquivo) && livro_aberturas.num_linhas < MAX_LINHAS_ABERTURA) {
-        // Remover quebra de linha
-        linha[strcspn(linha, "\n")] = 0;
-        
-        // Ignorar linhas vazias
-        if (strlen(linha) == 0) continue;
-        
-        // Processar comentários (nomes de aberturas)
-        if (linha[0] == '#') {
-            // Extrair nome da abertura
-            char *ptr = linha + 1;
-            while (*ptr == ' ') ptr++; // Pular espaços
-            if (strlen(ptr) > 0) {
-                strncpy(nome_abertura_atual, ptr, MAX_NOME_ABERTURA - 1);
-                nome_abertura_atual[MAX_NOME_ABERTURA - 1] = '\0';
-            }
-            continue;
-        }
-        
-        // Processar linha de lances
-        linha_abertura_t *linha_atual = &livro_aberturas.linhas[livro_aberturas.num_linhas];
-        strcpy(linha_atual->nome, nome_abertura_atual);
-        linha_atual->num_lances = 0;
-        
-        // Parsear lances na linha
-        char *token = strtok(linha, " ");
-        while (token != NULL && linha_atual->num_lances < MAX_LANCES_ABERTURA) {
-            // Copiar lance UCI
-            strncpy(linha_atual->lances_str[linha_atual->num_lances], token, 5);
-            linha_atual->lances_str[linha_atual->num_lances][5] = '\0';
-            
-            // Não converter para formato interno ainda - fazer na hora da comparação
-            linha_atual->lances_codificados[linha_atual->num_lances] = 0;
-            
-            linha_atual->num_lances++;
-            token = strtok(NULL, " ");
-        }
-        
-        if (linha_atual->num_lances > 0) {
-            livro_aberturas.num_linhas++;
-        }
+    return valor;
+}
+
+/**
+ * @brief Escreve um inteiro big-endian de 1 a 8 bytes
+ */
+static void escrever_big_endian(unsigned char *bytes, u64 valor, int tamanho) {
+    for (int i = tamanho - 1; i >= 0; i--) {
+        bytes[i] = (unsigned char)(valor & 0xFF);
+        valor >>= 8;
     }
-    
-    fclose(arquivo);
-    
-    livro_aberturas.inicializado = 1;
-    printf("info string Livro carregado: %d linhas de abertura\n", livro_aberturas.num_linhas);
-    
-    return 1;
 }
 
 /**
- * @brief Converte lance UCI para formato interno
+ * @brief Codifica um lance como no Polyglot
+ *
+ * Bits 0-5 destino, 6-11 origem, 12-14 promoção (1 cavalo ... 4 dama).
+ * O roque é gravado como rei captura a própria torre (e1h1, e1a1).
  */
-int converter_uci_para_interno(const char* lance_uci) {
-    if (strlen(lance_uci) < 4) return 0;
-    
-    // Salvar estado atual
-    estado_jogo backup;
-    SALVAR_ESTADO(backup);
-    
-    // Usar a função parse_move existente
-    int lance = parse_move((char*)lance_uci);
-    
-    // Restaurar estado
-    RESTAURAR_ESTADO(backup);
-    
-    return lance;
+static int lance_para_polyglot(int lance) {
+    int origem = get_origem(lance);
+    int destino = get_destino(lance);
+    int promocao = 0;
+
+    if (get_roque(lance)) {
+        destino = (destino > origem) ? origem + 3 : origem - 4;
+    }
+
+    switch (get_peca_promovida(lance)) {
+        case N: case n: promocao = 1; break;
+        case B: case b: promocao = 2; break;
+        case R: case r: promocao = 3; break;
+        case Q: case q: promocao = 4; break;
+    }
+
+    return destino | (origem << 6) | (promocao << 12);
 }
 
 /**
- * @brief Obtém o número do lance atual baseado no FEN
+ * @brief Ordena as entradas pela chave e, em empate, pelo lance
+ *
+ * Com os campos em big-endian a ordem dos bytes é a ordem numérica.
  */
-int obter_numero_lance_atual() {
-    // O número do lance está diretamente relacionado ao número de lances jogados
-    // Para as brancas: num_lances_partida é ímpar (lance 1, 3, 5...)
-    // Para as pretas: num_lances_partida é par (lance 2, 4, 6...)
-    
-    // Retorna qual o número do próximo lance a ser jogado
-    return num_lances_partida + 1;
+static int comparar_entradas(const void *a, const void *b) {
+    return memcmp(a, b, 10);
 }
 
 /**
- * @brief Obtém informações detalhadas do lance atual
+ * @brief Chave da posição no livro
+ *
+ * hash_chave inclui a coluna en passant sempre que houver casa de en passant,
+ * mesmo sem captura possível; assim a mesma posição teria chaves diferentes
+ * depois de um avanço duplo, por outra ordem de lances ou vinda de um FEN
+ * com "-". Como no Polyglot, a coluna só entra na chave do livro se um peão
+ * do lado a jogar puder capturar en passant.
  */
-void obter_info_lance_atual(int* numero_lance, int* eh_brancas) {
-    // Determina se é vez das brancas ou pretas
-    *eh_brancas = (num_lances_partida % 2 == 0) ? 1 : 0;
-    
-    // Calcula o número do lance no formato "lance completo"
-    // Lance 1 = 1º das brancas, Lance 2 = 1º das pretas
-    // Lance 3 = 2º das brancas, Lance 4 = 2º das pretas, etc.
-    *numero_lance = num_lances_partida + 1;
+static u64 chave_livro(const posicao_t *pos) {
+    u64 chave = pos->hash_chave;
+
+    if (pos->en_passant != -999) {
+        int lado = pos->lado_a_jogar;
+        u64 capturadores = tabela_ataques_peao[lado ^ 1][pos->en_passant] & pos->bitboards[(lado == branco) ? P : p];
+
+        if (!capturadores) {
+            chave ^= chaves_en_passant[pos->en_passant % 8];
+        }
+    }
+
+    return chave;
 }
 
+// =============================================================================
+// COMPILAÇÃO DE ABERTURAS.TXT
+// =============================================================================
+
 /**
- * @brief Converte lance interno para string UCI
+ * @brief Joga cada linha do arquivo texto e gera as entradas ordenadas
+ *
+ * @param arquivo_texto Arquivo no formato de aberturas.txt
+ * @param entradas Recebe as entradas alocadas com malloc (liberar com free)
+ * @param num_entradas Recebe o número de entradas
+ * @return 1 se sucesso, 0 se o arquivo não pôde ser lido
  */
-void lance_interno_para_uci(int lance, char* uci_str) {
-    int origem = get_origem(lance);
-    int destino = get_destino(lance);
-    int promocao = get_peca_promovida(lance);
-    
-    // Converter coordenadas para notação UCI
-    char origem_str[3] = {(origem % 8) + 'a', (origem / 8) + '1', '\0'};
-    char destino_str[3] = {(destino % 8) + 'a', (destino / 8) + '1', '\0'};
-    
-    strcpy(uci_str, origem_str);
-    strcat(uci_str, destino_str);
-    
-    // Adicionar promoção se houver
-    if (promocao) {
-        switch (promocao) {
-            case Q: strcat(uci_str, "q"); break;
-            case R: strcat(uci_str, "r"); break;
-            case B: strcat(uci_str, "b"); break;
-            case N: strcat(uci_str, "n"); break;
+static int compilar_livro_texto(const char *arquivo_texto, unsigned char **entradas, size_t *num_entradas) {
+    FILE *arquivo = fopen(arquivo_texto, "r");
+    if (arquivo == NULL) {
+        return 0;
+    }
+
+    unsigned char *buffer = NULL;
+    size_t quantidade = 0;
+    size_t capacidade = 0;
+    char linha[512];
+
+    while (fgets(linha, sizeof(linha), arquivo)) {
+        // Comentários (nomes das aberturas) e linhas vazias
+        if (linha[0] == '#') continue;
+
+        posicao_t pos;
+        char fen[sizeof(fen_inicial)];
+        memcpy(fen, fen_inicial, sizeof(fen_inicial));
+        parseFEN(&pos, fen);
+
+        int num_lances = 0;
+        char *token = strtok(linha, " \t\r\n");
+        while (token != NULL && num_lances < MAX_LANCES_ABERTURA) {
+            int lance = (strlen(token) >= 4) ? parse_move(&pos, token) : 0;
+            if (lance == 0) {
+                printf("info string Aviso: lance %s invalido em %s\n", token, arquivo_texto);
+                break;
+            }
+
+            if (quantidade == capacidade) {
+                capacidade = capacidade ? capacidade * 2 : 256;
+                unsigned char *maior = realloc(buffer, capacidade * TAMANHO_ENTRADA_LIVRO);
+                if (maior == NULL) {
+                    free(buffer);
+                    fclose(arquivo);
+                    return 0;
+                }
+                buffer = maior;
+            }
+
+            // Entrada: posição antes do lance, lance, peso 1, aprendizado 0
+            unsigned char *entrada = buffer + quantidade * TAMANHO_ENTRADA_LIVRO;
+            escrever_big_endian(entrada, chave_livro(&pos), 8);
+            escrever_big_endian(entrada + 8, lance_para_polyglot(lance), 2);
+            escrever_big_endian(entrada + 10, 1, 2);
+            escrever_big_endian(entrada + 12, 0, 4);
+            quantidade++;
+
+            registro_desfazer desfazer;
+            if (!fazer_lance(&pos, lance, todosLances, &desfazer)) {
+                break;
+            }
+
+            num_lances++;
+            token = strtok(NULL, " \t\r\n");
+        }
+    }
+
+    fclose(arquivo);
+
+    // As linhas repetem os prefixos umas das outras: ordenar e remover duplicatas
+    if (quantidade > 0) {
+        qsort(buffer, quantidade, TAMANHO_ENTRADA_LIVRO, comparar_entradas);
+
+        size_t unicas = 1;
+        for (size_t i = 1; i < quantidade; i++) {
+            unsigned char *anterior = buffer + (unicas - 1) * TAMANHO_ENTRADA_LIVRO;
+            unsigned char *atual = buffer + i * TAMANHO_ENTRADA_LIVRO;
+            if (comparar_entradas(anterior, atual) != 0) {
+                memmove(buffer + unicas * TAMANHO_ENTRADA_LIVRO, atual, TAMANHO_ENTRADA_LIVRO);
+                unicas++;
+            }
         }
+        quantidade = unicas;
+    }
+
+    *entradas = buffer;
+    *num_entradas = quantidade;
+    return 1;
+}
+
+int gerar_livro_binario(const char *arquivo_texto, const char *arquivo_binario) {
+    unsigned char *entradas;
+    size_t num_entradas;
+
+    if (!compilar_livro_texto(arquivo_texto, &entradas, &num_entradas)) {
+        printf("Erro: nao foi possivel ler %s\n", arquivo_texto);
+        return 1;
+    }
+
+    FILE *saida = fopen(arquivo_binario, "wb");
+    if (saida == NULL) {
+        printf("Erro: nao foi possivel criar %s\n", arquivo_binario);
+        free(entradas);
+        return 1;
+    }
+
+    size_t escritas = fwrite(entradas, TAMANHO_ENTRADA_LIVRO, num_entradas, saida);
+    int erro = fclose(saida) != 0 || escritas != num_entradas;
+    free(entradas);
+
+    if (erro) {
+        printf("Erro: falha ao escrever %s\n", arquivo_binario);
+        return 1;
     }
+
+    printf("Livro %s: %zu entradas\n", arquivo_binario, num_entradas);
+    return 0;
 }
 
+// =============================================================================
+// CARREGAMENTO DO LIVRO BINÁRIO
+// =============================================================================
+
 /**
- * @brief Compara histórico com linha do livro usando strings UCI
+ * @brief Mapeia o livro binário na memória (somente leitura)
+ *
+ * Sem mmap (Windows), o arquivo é lido inteiro para a memória.
+ *
+ * @return 1 se o arquivo existe e tem ao menos uma entrada completa
  */
-int comparar_historico_com_linha_uci(int historico[], int num_jogados, linha_abertura_t* linha) {
-    // CORREÇÃO CRÍTICA: O histórico deve coincidir EXATAMENTE com o início da linha
-    // Se temos mais lances jogados do que a linha tem, não pode coincidir
-    if (num_jogados > linha->num_lances) {
+static int carregar_livro_binario(const char *arquivo_binario) {
+#ifdef _WIN32
+    FILE *arquivo = fopen(arquivo_binario, "rb");
+    if (arquivo == NULL) {
+        return 0;
+    }
+
+    fseek(arquivo, 0, SEEK_END);
+    long tamanho = ftell(arquivo);
+    fseek(arquivo, 0, SEEK_SET);
+
+    if (tamanho < TAMANHO_ENTRADA_LIVRO) {
+        fclose(arquivo);
         return 0;
     }
-    
-    // Compara todos os lances jogados com o início da linha
-    for (int i = 0; i < num_jogados; i++) {
-        char lance_uci[8];
-        lance_interno_para_uci(historico[i], lance_uci);
-        
-        if (strcmp(lance_uci, linha->lances_str[i]) != 0) {
+
+    void *memoria = malloc(tamanho);
+    if (memoria == NULL || fread(memoria, 1, tamanho, arquivo) != (size_t)tamanho) {
+        free(memoria);
+        fclose(arquivo);
+        return 0;
+    }
+    fclose(arquivo);
+
+    livro_aberturas.mapeado = 0;
+#else
+    int descritor = open(arquivo_binario, O_RDONLY);
+    if (descritor < 0) {
+        return 0;
+    }
+
+    struct stat info;
+    if (fstat(descritor, &info) != 0 || info.st_size < TAMANHO_ENTRADA_LIVRO) {
+        close(descritor);
+        return 0;
+    }
+
+    size_t tamanho = (size_t)info.st_size;
+    void *memoria = mmap(NULL, tamanho, PROT_READ, MAP_PRIVATE, descritor, 0);
+    close(descritor);
+
+    if (memoria == MAP_FAILED) {
+        return 0;
+    }
+
+    livro_aberturas.mapeado = 1;
+#endif
+
+    livro_aberturas.memoria = memoria;
+    livro_aberturas.tamanho_memoria = (size_t)tamanho;
+    livro_aberturas.entradas = memoria;
+    livro_aberturas.num_entradas = (size_t)tamanho / TAMANHO_ENTRADA_LIVRO;
+    return 1;
+}
+
+/**
+ * @brief Inicializa o sistema de livro de aberturas
+ */
+int inicializar_livro_aberturas() {
+    // Inicializar o random seed
+    srand(time(NULL));
+
+    finalizar_livro_aberturas();
+
+    const char *origem = ARQUIVO_LIVRO_BINARIO;
+
+    if (!carregar_livro_binario(ARQUIVO_LIVRO_BINARIO)) {
+        // Sem livro compilado: compila aberturas.txt na memória
+        unsigned char *entradas;
+        size_t num_entradas;
+
+        if (!compilar_livro_texto(ARQUIVO_LIVRO_TEXTO, &entradas, &num_entradas) || num_entradas == 0) {
+            printf("info string Aviso: livro de aberturas nao encontrado\n");
             return 0;
         }
+
+        livro_aberturas.memoria = entradas;
+        livro_aberturas.tamanho_memoria = num_entradas * TAMANHO_ENTRADA_LIVRO;
+        livro_aberturas.entradas = entradas;
+        livro_aberturas.num_entradas = num_entradas;
+        livro_aberturas.mapeado = 0;
+        origem = ARQUIVO_LIVRO_TEXTO;
     }
-    
+
+    livro_aberturas.inicializado = 1;
+    printf("info string Livro carregado: %zu entradas (%s)\n", livro_aberturas.num_entradas, origem);
+
     return 1;
 }
 
+// =============================================================================
+// CONSULTA
+// =============================================================================
+
+/**
+ * @brief Índice da primeira entrada com chave >= chave (busca binária)
+ */
+static size_t primeira_entrada(u64 chave) {
+    size_t inicio = 0;
+    size_t fim = livro_aberturas.num_entradas;
+
+    while (inicio < fim) {
+        size_t meio = inicio + (fim - inicio) / 2;
+        if (ler_big_endian(livro_aberturas.entradas + meio * TAMANHO_ENTRADA_LIVRO, 8) < chave) {
+            inicio = meio + 1;
+        } else {
+            fim = meio;
+        }
+    }
+
+    return inicio;
+}
+
 /**
  * @brief Busca um lance de abertura para a posição atual
  */
-int buscar_lance_abertura(int historico_lances[], int num_lances_jogados) {
+int buscar_lance_abertura(const posicao_t *pos) {
     if (!livro_aberturas.inicializado) {
         return 0;
     }
-    
-    // Arrays para armazenar lances candidatos e suas informações
-    int candidatos[MAX_LINHAS_ABERTURA];
-    char nomes_aberturas[MAX_LINHAS_ABERTURA][MAX_NOME_ABERTURA];
+
+    u64 chave = chave_livro(pos);
+    size_t indice = primeira_entrada(chave);
+    if (indice == livro_aberturas.num_entradas ||
+        ler_big_endian(livro_aberturas.entradas + indice * TAMANHO_ENTRADA_LIVRO, 8) != chave) {
+        return 0;
+    }
+
+    lances lista;
+    gerar_lances(pos, &lista);
+
+    int candidatos[MAX_CANDIDATOS_LIVRO];
+    int pesos[MAX_CANDIDATOS_LIVRO];
     int num_candidatos = 0;
-    
-    // Buscar todas as linhas que correspondem ao histórico atual
-    for (int i = 0; i < livro_aberturas.num_linhas; i++) {
-        linha_abertura_t *linha = &livro_aberturas.linhas[i];
-        
-        // Verificar se esta linha corresponde ao histórico E tem um próximo lance
-        if (comparar_historico_com_linha_uci(historico_lances, num_lances_jogados, linha) &&
-            linha->num_lances > num_lances_jogados) {
-            
-            // Converter o próximo lance UCI para formato interno
-            int lance_candidato = converter_uci_para_interno(linha->lances_str[num_lances_jogados]);
-            int ja_existe = 0;
-            
-            for (int j = 0; j < num_candidatos; j++) {
-                if (candidatos[j] == lance_candidato) {
-                    ja_existe = 1;
-                    break;
-                }
-            }
-            
-            if (!ja_existe) {
-                candidatos[num_candidatos] = lance_candidato;
-                strncpy(nomes_aberturas[num_candidatos], linha->nome, MAX_NOME_ABERTURA - 1);
-                nomes_aberturas[num_candidatos][MAX_NOME_ABERTURA - 1] = '\0';
+    int peso_total = 0;
+
+    // Entradas da mesma chave são consecutivas
+    for (; indice < livro_aberturas.num_entradas && num_candidatos < MAX_CANDIDATOS_LIVRO; indice++) {
+        const unsigned char *entrada = livro_aberturas.entradas + indice * TAMANHO_ENTRADA_LIVRO;
+        if (ler_big_endian(entrada, 8) != chave) break;
+
+        int lance_livro = (int)ler_big_endian(entrada + 8, 2);
+        int peso = (int)ler_big_endian(entrada + 10, 2);
+        if (peso == 0) continue;
+
+        // Só lances legais: protege contra colisão de chave e livros corrompidos
+        for (int i = 0; i < lista.contador; i++) {
+            if (lance_para_polyglot(lista.lances[i]) == lance_livro) {
+                candidatos[num_candidatos] = lista.lances[i];
+                pesos[num_candidatos] = peso;
+                peso_total += peso;
                 num_candidatos++;
+                break;
             }
         }
     }
-    
+
     // Se não há candidatos, sair do livro
     if (num_candidatos == 0) {
         return 0;
     }
-    
-    // Escolher um lance aleatório entre os candidatos
-    int indice_escolhido = rand() % num_candidatos;
-    
-    printf("info string Lance escolhido do livro: %s (%d opcoes disponiveis)\n", 
-           nomes_aberturas[indice_escolhido], num_candidatos);
-    
+
+    // Escolher um lance com probabilidade proporcional ao peso
+    int sorteio = rand() % peso_total;
+    int indice_escolhido = 0;
+    while (sorteio >= pesos[indice_escolhido]) {
+        sorteio -= pesos[indice_escolhido];
+        indice_escolhido++;
+    }
+
+    char lance_uci[8];
+    lance_para_uci(candidatos[indice_escolhido], lance_uci);
+    printf("info string Lance escolhido do livro: %s (%d opcoes disponiveis)\n",
+           lance_uci, num_candidatos);
+
     return candidatos[indice_escolhido];
 }
 
+// =============================================================================
+// CONFERÊNCIA DE TRANSPOSIÇÕES
+// =============================================================================
+
 /**
- * @brief Verifica se a engine ainda está "em livro"
+ * @brief Caminho até uma posição: FEN de partida (NULL = posição inicial) e lances em UCI
  */
-int esta_em_livro(int historico_lances[], int num_lances_jogados) {
-    if (!livro_aberturas.inicializado) {
-        return 0;
+typedef struct {
+    const char *fen;
+    const char *lances;
+} caminho_livro_t;
+
+/**
+ * @brief Pares de caminhos que chegam à mesma posição do livro
+ */
+static const caminho_livro_t transposicoes_livro[][2] = {
+    // Último lance é um avanço duplo sem captura en passant possível
+    {{NULL, "e2e4 e7e5 g1f3"}, {NULL, "g1f3 e7e5 e2e4"}},
+    {{NULL, "e2e4 e7e5"}, {NULL, "e2e3 e7e6 e3e4 e6e5"}},
+    // A mesma posição vinda de um FEN sem casa de en passant
+    {{NULL, "e2e4"}, {"rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq - 0 1", ""}},
+    {{NULL, "d2d4 g8f6 c2c4 e7e6"}, {NULL, "c2c4 e7e6 d2d4 g8f6"}},
+};
+
+/**
+ * @brief Monta a posição de um caminho; retorna 0 se algum lance for inválido
+ */
+static int jogar_caminho(posicao_t *pos, const caminho_livro_t *caminho) {
+    char fen[128];
+    snprintf(fen, sizeof(fen), "%s", caminho->fen ? caminho->fen : fen_inicial);
+    parseFEN(pos, fen);
+
+    char lances_str[256];
+    snprintf(lances_str, sizeof(lances_str), "%s", caminho->lances);
+
+    for (char *token = strtok(lances_str, " "); token != NULL; token = strtok(NULL, " ")) {
+        int lance = parse_move(pos, token);
+        registro_desfazer desfazer;
+        if (lance == 0 || !fazer_lance(pos, lance, todosLances, &desfazer)) {
+            return 0;
+        }
     }
-    
-    // Verificar se alguma linha ainda corresponde ao histórico
-    for (int i = 0; i < livro_aberturas.num_linhas; i++) {
-        linha_abertura_t *linha = &livro_aberturas.linhas[i];
-        
-        if (comparar_historico_com_linha_uci(historico_lances, num_lances_jogados, linha) &&
-            linha->num_lances > num_lances_jogados) {
-            return 1;
+
+    return 1;
+}
+
+int conferir_transposicoes_livro() {
+    int num_pares = sizeof(transposicoes_livro) / sizeof(transposicoes_livro[0]);
+    int falhas = 0;
+
+    for (int i = 0; i < num_pares; i++) {
+        const caminho_livro_t *par = transposicoes_livro[i];
+        posicao_t pos_a, pos_b;
+        int ok = jogar_caminho(&pos_a, &par[0]) && jogar_caminho(&pos_b, &par[1]);
+        u64 chave_a = ok ? chave_livro(&pos_a) : 0;
+
+        // Mesma chave e, com o livro carregado, a posição está nele
+        ok = ok && chave_a == chave_livro(&pos_b);
+        if (ok && livro_aberturas.inicializado) {
+            size_t indice = primeira_entrada(chave_a);
+            ok = indice < livro_aberturas.num_entradas &&
+                 ler_big_endian(livro_aberturas.entradas + indice * TAMANHO_ENTRADA_LIVRO, 8) == chave_a;
         }
+
+        printf("%2d %-7s %s = %s\n", i + 1, ok ? "OK" : "FALHOU",
+               par[0].fen ? par[0].fen : par[0].lances, par[1].fen ? par[1].fen : par[1].lances);
+        falhas += !ok;
     }
-    
-    return 0;
+
+    printf("Transposicoes: %d, falhas: %d\n", num_pares, falhas);
+    return falhas;
 }
 
 /**
  * @brief Libera recursos do livro de aberturas
  */
 void finalizar_livro_aberturas() {
+    if (livro_aberturas.memoria != NULL) {
+#ifndef _WIN32
+        if (livro_aberturas.mapeado) {
+            munmap(livro_aberturas.memoria, livro_aberturas.tamanho_memoria);
+        } else
+#endif
+        {
+            free(livro_aberturas.memoria);
+        }
+    }
+
+    livro_aberturas.memoria = NULL;
+    livro_aberturas.entradas = NULL;
+    livro_aberturas.num_entradas = 0;
+    livro_aberturas.tamanho_memoria = 0;
+    livro_aberturas.mapeado = 0;
     livro_aberturas.inicializado = 0;
-    livro_aberturas.num_linhas = 0;
 }
@@ -13,11 +13,20 @@
 #include "../include/globals.h"
 #include "../include/bitboard.h"
 #include "../include/evaluate.h"
+#include "../include/transposicao.h"
+#include "../include/search.h"
 
 #include <stdio.h>
 #include <string.h>
 #include <sys/time.h>
 
+#ifdef USAR_PEXT
+#ifndef __BMI2__
+#error "USAR_PEXT requer uma CPU com BMI2 (compile com -mbmi2 ou use make bmi2)"
+#endif
+#include <immintrin.h>
+#endif
+
 // =============================================================================
 // FUNÇÕES DE TEMPO E NÚMEROS ALEATÓRIOS
 // =============================================================================
@@ -262,6 +271,7 @@ void marcarAtaquesDirecionaisComBloqueio(u64 *ataque, int linha, int coluna, int
 // Gera os ataques pré-definidos para as peças
 void inicializarAtaquesPecas()
 {
+#ifndef TABELAS_PRECALCULADAS
     for (int casa = 0; casa < 64; casa++)
     {
         // peões
@@ -273,15 +283,22 @@ void inicializarAtaquesPecas()
 
         // rei
         tabela_ataques_rei[casa] = gerarAtaquesRei(casa);
-
-        // bispo e torre
-        inicializarAtaquesPecasDeslizantes(bispo);
-        inicializarAtaquesPecasDeslizantes(torre);
     }
+
+    // bispo e torre (cada chamada já percorre as 64 casas)
+    inicializarAtaquesPecasDeslizantes(bispo);
+    inicializarAtaquesPecasDeslizantes(torre);
+#endif
 }
 
 void inicializarAtaquesPecasDeslizantes(int peca)
 {
+#ifdef TABELAS_PRECALCULADAS
+    (void)peca;
+#else
+    // Bispos no início da tabela, torres logo depois; as casas ficam em trechos consecutivos
+    u64 *proximo = (peca == bispo) ? tabela_ataques_deslizantes : tabela_ataques_deslizantes + TAMANHO_ATAQUES_BISPO;
+
     for (int casa = 0; casa < 64; casa++)
     {
 
@@ -296,47 +313,58 @@ void inicializarAtaquesPecasDeslizantes(int peca)
 
         int indices_ocupacao = 1 << bits_relevantes;
 
+        if (peca == bispo)
+            ataques_bispo[casa] = proximo;
+        else
+            ataques_torre[casa] = proximo;
+
         for (int i = 0; i < indices_ocupacao; i++)
         {
+            u64 ocupacao = set_occupancy(i, bits_relevantes, ataque_mask);
 
-            if (peca == bispo)
-            {
-                u64 ocupacao = set_occupancy(i, bits_relevantes, ataque_mask);
-
-                int indice_magico = (ocupacao * magics_bispo[casa]) >> (64 - bits_relevantes);
-
-                tabela_ataques_bispo[casa][indice_magico] = gerarAtaquesBispoComBloqueio(casa, ocupacao);
-            }
-            else if (peca == torre)
-            {
-                u64 ocupacao = set_occupancy(i, bits_relevantes, ataque_mask);
-
-                int indice_magico = (ocupacao * magics_torre[casa]) >> (64 - bits_relevantes);
+#ifdef USAR_PEXT
+            // set_occupancy() distribui os bits de i pela máscara, então pext devolve o próprio i
+            int indice = i;
+#else
+            u64 magic = (peca == bispo) ? magics_bispo[casa] : magics_torre[casa];
+            int indice = (int)((ocupacao * magic) >> (64 - bits_relevantes));
+#endif
 
-                tabela_ataques_torre[casa][indice_magico] = gerarAtaquesTorreComBloqueio(casa, ocupacao);
-            }
+            if (peca == bispo)
+                proximo[indice] = gerarAtaquesBispoComBloqueio(casa, ocupacao);
+            else
+                proximo[indice] = gerarAtaquesTorreComBloqueio(casa, ocupacao);
         }
+
+        proximo += indices_ocupacao;
     }
+#endif
 }
 
 u64 obterAtaquesBispo(int casa, u64 ocupacao)
 {
-
+#ifdef USAR_PEXT
+    return ataques_bispo[casa][_pext_u64(ocupacao, mask_tabela_ataques_bispo[casa])];
+#else
     ocupacao &= mask_tabela_ataques_bispo[casa];
     ocupacao *= magics_bispo[casa];
     ocupacao >>= (64 - bits_relevantes_bispo[casa]);
 
-    return tabela_ataques_bispo[casa][ocupacao]; // Retorna o ataque correspondente ao índice calculado
+    return ataques_bispo[casa][ocupacao]; // Retorna o ataque correspondente ao índice calculado
+#endif
 }
 
 u64 obterAtaquesTorre(int casa, u64 ocupacao)
 {
-
+#ifdef USAR_PEXT
+    return ataques_torre[casa][_pext_u64(ocupacao, mask_tabela_ataques_torre[casa])];
+#else
     ocupacao &= mask_tabela_ataques_torre[casa];
     ocupacao *= magics_torre[casa];
     ocupacao >>= (64 - bits_relevantes_torre[casa]);
 
-    return tabela_ataques_torre[casa][ocupacao]; // Retorna o ataque correspondente ao índice calculado
+    return ataques_torre[casa][ocupacao]; // Retorna o ataque correspondente ao índice calculado
+#endif
 }
 
 u64 obterAtaquesDama(int casa, u64 ocupacao)
@@ -344,6 +372,38 @@ u64 obterAtaquesDama(int casa, u64 ocupacao)
     return (obterAtaquesBispo(casa, ocupacao) | obterAtaquesTorre(casa, ocupacao)); // A dama ataca como bispo e torre
 }
 
+// Preenche casas_entre e linha_casas a partir dos ataques em tabuleiro vazio
+void inicializarTabelasAlinhamento()
+{
+#ifndef TABELAS_PRECALCULADAS
+    for (int origem = 0; origem < 64; origem++)
+    {
+        for (int destino = 0; destino < 64; destino++)
+        {
+            casas_entre[origem][destino] = 0ULL;
+            linha_casas[origem][destino] = 0ULL;
+
+            if (origem == destino)
+                continue;
+
+            u64 bb_origem = 1ULL << origem;
+            u64 bb_destino = 1ULL << destino;
+
+            if (obterAtaquesBispo(origem, 0ULL) & bb_destino)
+            {
+                casas_entre[origem][destino] = obterAtaquesBispo(origem, bb_destino) & obterAtaquesBispo(destino, bb_origem);
+                linha_casas[origem][destino] = (obterAtaquesBispo(origem, 0ULL) & obterAtaquesBispo(destino, 0ULL)) | bb_origem | bb_destino;
+            }
+            else if (obterAtaquesTorre(origem, 0ULL) & bb_destino)
+            {
+                casas_entre[origem][destino] = obterAtaquesTorre(origem, bb_destino) & obterAtaquesTorre(destino, bb_origem);
+                linha_casas[origem][destino] = (obterAtaquesTorre(origem, 0ULL) & obterAtaquesTorre(destino, 0ULL)) | bb_origem | bb_destino;
+            }
+        }
+    }
+#endif
+}
+
 // Gera o bitboard de ataques possíveis de um peão a partir da casa fornecida
 u64 gerarAtaquesPeao(int lado, int casa)
 {
@@ -534,498 +594,887 @@ void runEngine()
 {
 
     inicializarAtaquesPecas();
+    inicializarTabelasAlinhamento();
     init_evaluation_masks();
+    inicializar_chaves_hash();
+    inicializar_tt(TT_TAMANHO_PADRAO_MB);
+    inicializar_tt_perft(TT_PERFT_TAMANHO_PADRAO_MB);
+    inicializar_reducoes();
 
 }
 
-int casaEstaAtacada(int casa, int lado)
+int casaEstaAtacada(const posicao_t *pos, int casa, int lado)
 {
 
-    if ((lado == branco) && (tabela_ataques_peao[preto][casa] & bitboards[P]))
+    if ((lado == branco) && (tabela_ataques_peao[preto][casa] & pos->bitboards[P]))
         return 1;
 
-    if ((lado == preto) && (tabela_ataques_peao[branco][casa] & bitboards[p]))
+    if ((lado == preto) && (tabela_ataques_peao[branco][casa] & pos->bitboards[p]))
         return 1;
 
-    if (tabela_ataques_cavalo[casa] & ((lado == branco) ? bitboards[N] : bitboards[n]))
+    if (tabela_ataques_cavalo[casa] & ((lado == branco) ? pos->bitboards[N] : pos->bitboards[n]))
         return 1;
 
-    if (obterAtaquesBispo(casa, ocupacoes[ambos]) & ((lado == branco) ? bitboards[B] : bitboards[b]))
+    if (obterAtaquesBispo(casa, pos->ocupacoes[ambos]) & ((lado == branco) ? pos->bitboards[B] : pos->bitboards[b]))
         return 1;
 
-    if (obterAtaquesTorre(casa, ocupacoes[ambos]) & ((lado == branco) ? bitboards[R] : bitboards[r]))
+    if (obterAtaquesTorre(casa, pos->ocupacoes[ambos]) & ((lado == branco) ? pos->bitboards[R] : pos->bitboards[r]))
         return 1;
 
-    if (obterAtaquesDama(casa, ocupacoes[ambos]) & ((lado == branco) ? bitboards[Q] : bitboards[q]))
+    if (obterAtaquesDama(casa, pos->ocupacoes[ambos]) & ((lado == branco) ? pos->bitboards[Q] : pos->bitboards[q]))
         return 1;
 
-    if (tabela_ataques_rei[casa] & ((lado == branco) ? bitboards[K] : bitboards[k]))
+    if (tabela_ataques_rei[casa] & ((lado == branco) ? pos->bitboards[K] : pos->bitboards[k]))
         return 1;
 
     return 0;
 }
 
-// Função auxiliar para gerar movimentos de peões brancos
-void gerar_movimentos_peao_branco(int origem, lances *listaLances)
+u64 atacantes_casa(const posicao_t *pos, int casa, int lado, u64 ocupacao)
+{
+    int base = (lado == branco) ? P : p; // peças do lado atacante vão de base a base + 5
+    u64 damas = pos->bitboards[base + 4];
+
+    return (tabela_ataques_peao[lado ^ 1][casa] & pos->bitboards[base]) |
+           (tabela_ataques_cavalo[casa] & pos->bitboards[base + 1]) |
+           (obterAtaquesBispo(casa, ocupacao) & (pos->bitboards[base + 2] | damas)) |
+           (obterAtaquesTorre(casa, ocupacao) & (pos->bitboards[base + 3] | damas)) |
+           (tabela_ataques_rei[casa] & pos->bitboards[base + 5]);
+}
+
+int fazer_lance(posicao_t *pos, int lance, int flag, registro_desfazer *desfazer)
 {
-    int destino = origem + 8;
 
-    // Movimento simples
-    if (destino < 64 && !getBit(ocupacoes[ambos], destino))
+    if (flag == todosLances)
     {
-        if (origem >= a7 && origem <= h7)
-        { // 7ª linha (promoção)
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, Q, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, R, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, B, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, N, 0, 0, 0, 0));
+
+        // Guarda apenas o que não pode ser deduzido do próprio lance
+        desfazer->peca_capturada = -1;
+        desfazer->roque = pos->roque;
+        desfazer->en_passant = pos->en_passant;
+        desfazer->hash = pos->hash_chave;
+
+        int origem = get_origem(lance);
+        int destino = get_destino(lance);
+        int peca = get_peca(lance);
+        int promocao = get_peca_promovida(lance);
+        int captura = get_captura(lance);
+        int movimento_duplo = get_double_push(lance);
+        int en_passant_flag = get_en_passant(lance);
+        int roque_flag = get_roque(lance);
+
+        // Peça capturada lida do mailbox antes de o destino ser sobrescrito
+        // (no en passant o destino está vazio)
+        if (captura && !en_passant_flag)
+        {
+            int capturada = pos->peca_na_casa[destino];
+            clearBit(pos->bitboards[capturada], destino);
+            pos->ocupacoes[pos->lado_a_jogar ^ 1] ^= 1ULL << destino;
+            pos->hash_chave ^= chaves_pecas[capturada][destino];
+            desfazer->peca_capturada = capturada;
         }
-        else
+
+        clearBit(pos->bitboards[peca], origem);
+        setBit(pos->bitboards[peca], destino);
+        pos->ocupacoes[pos->lado_a_jogar] ^= (1ULL << origem) | (1ULL << destino);
+        pos->peca_na_casa[origem] = SEM_PECA;
+        pos->peca_na_casa[destino] = promocao ? promocao : peca;
+
+        // hash: peça sai da origem e entra no destino
+        pos->hash_chave ^= chaves_pecas[peca][origem];
+        pos->hash_chave ^= chaves_pecas[peca][destino];
+
+        if (promocao)
+        {
+            if ( pos->lado_a_jogar == branco) {
+                clearBit(pos->bitboards[P], destino);
+                pos->hash_chave ^= chaves_pecas[P][destino];
+            } else {
+                clearBit(pos->bitboards[p], destino);
+                pos->hash_chave ^= chaves_pecas[p][destino];
+            }
+
+            setBit(pos->bitboards[promocao], destino);
+            pos->hash_chave ^= chaves_pecas[promocao][destino];
+        }
+
+        if(en_passant_flag) {
+            if (pos->lado_a_jogar == branco) {
+                clearBit(pos->bitboards[p], destino - 8);
+                pos->ocupacoes[preto] ^= 1ULL << (destino - 8);
+                pos->peca_na_casa[destino - 8] = SEM_PECA;
+                pos->hash_chave ^= chaves_pecas[p][destino - 8];
+                desfazer->peca_capturada = p;
+            } else {
+                clearBit(pos->bitboards[P], destino + 8);
+                pos->ocupacoes[branco] ^= 1ULL << (destino + 8);
+                pos->peca_na_casa[destino + 8] = SEM_PECA;
+                pos->hash_chave ^= chaves_pecas[P][destino + 8];
+                desfazer->peca_capturada = P;
+            }
+        }   
+
+        if (pos->en_passant != -999)
         {
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, 0, 0, 0, 0, 0));
+            pos->hash_chave ^= chaves_en_passant[pos->en_passant % 8];
+        }
+
+        pos->en_passant = -999;
+
+        if (movimento_duplo)
+        {
+            if (pos->lado_a_jogar == branco)
+            {
+                pos->en_passant = origem + 8;
+            }
+            else
+            {
+                pos->en_passant = origem - 8;
+            }
+
+            pos->hash_chave ^= chaves_en_passant[pos->en_passant % 8];
+        }
 
-            // Movimento duplo do peão (da 2ª linha)
-            if (origem >= a2 && origem <= h2)
+        if (roque_flag)
+        {
+            if (pos->lado_a_jogar == branco)
+            {
+                // Roque pequeno
+                if (destino == g1)
+                {
+                    clearBit(pos->bitboards[R], h1);
+                    setBit(pos->bitboards[R], f1);
+                    pos->ocupacoes[branco] ^= (1ULL << h1) | (1ULL << f1);
+                    pos->peca_na_casa[h1] = SEM_PECA;
+                    pos->peca_na_casa[f1] = R;
+                    pos->hash_chave ^= chaves_pecas[R][h1] ^ chaves_pecas[R][f1];
+                }
+                // Roque grande
+                else if (destino == c1)
+                {
+                    clearBit(pos->bitboards[R], a1);
+                    setBit(pos->bitboards[R], d1);
+                    pos->ocupacoes[branco] ^= (1ULL << a1) | (1ULL << d1);
+                    pos->peca_na_casa[a1] = SEM_PECA;
+                    pos->peca_na_casa[d1] = R;
+                    pos->hash_chave ^= chaves_pecas[R][a1] ^ chaves_pecas[R][d1];
+                }
+            }
+            else
             {
-                destino = origem + 16;
-                if (destino < 64 && !getBit(ocupacoes[ambos], destino))
+                // Roque pequeno
+                if (destino == g8)
+                {
+                    clearBit(pos->bitboards[r], h8);
+                    setBit(pos->bitboards[r], f8);
+                    pos->ocupacoes[preto] ^= (1ULL << h8) | (1ULL << f8);
+                    pos->peca_na_casa[h8] = SEM_PECA;
+                    pos->peca_na_casa[f8] = r;
+                    pos->hash_chave ^= chaves_pecas[r][h8] ^ chaves_pecas[r][f8];
+                }
+                // Roque grande
+                else if (destino == c8)
                 {
-                    adicionarLance(listaLances, codificar_lance(origem, destino, P, 0, 0, 1, 0, 0));
+                    clearBit(pos->bitboards[r], a8);
+                    setBit(pos->bitboards[r], d8);
+                    pos->ocupacoes[preto] ^= (1ULL << a8) | (1ULL << d8);
+                    pos->peca_na_casa[a8] = SEM_PECA;
+                    pos->peca_na_casa[d8] = r;
+                    pos->hash_chave ^= chaves_pecas[r][a8] ^ chaves_pecas[r][d8];
                 }
             }
         }
-    }
 
-    // Capturas
-    u64 ataques = tabela_ataques_peao[branco][origem] & ocupacoes[preto];
-    while (ataques)
+        //roque
+        pos->hash_chave ^= chaves_roque[pos->roque];
+        pos->roque &= roque_permissoes[origem];
+        pos->roque &= roque_permissoes[destino];
+        pos->hash_chave ^= chaves_roque[pos->roque];
+
+        // as ocupações por lado já foram atualizadas casa a casa
+        pos->ocupacoes[ambos] = pos->ocupacoes[branco] | pos->ocupacoes[preto];
+
+        // mudar lado a jogar
+        pos->lado_a_jogar ^= 1; 
+        pos->hash_chave ^= chave_lado;
+
+        // o gerador só produz lances legais: não é preciso testar o rei aqui
+        return 1;
+
+    }
+    else
     {
-        destino = getLeastBitIndex(ataques);
-
-        if (origem >= a7 && origem <= h7)
-        { // 7ª linha (promoção)
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, Q, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, R, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, B, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, N, 1, 0, 0, 0));
+        if (get_captura(lance))
+        {
+            return fazer_lance(pos, lance, todosLances, desfazer);
         }
         else
         {
-            adicionarLance(listaLances, codificar_lance(origem, destino, P, 0, 1, 0, 0, 0));
+            return 0;
+        }
+    }
+
+
+}
+
+void desfazer_lance(posicao_t *pos, int lance, registro_desfazer *desfazer)
+{
+    int origem = get_origem(lance);
+    int destino = get_destino(lance);
+    int peca = get_peca(lance);
+    int promocao = get_peca_promovida(lance);
+
+    // volta para o lado que fez o lance
+    pos->lado_a_jogar ^= 1;
+
+    // peça volta do destino para a origem (na promoção, sai a peça promovida)
+    clearBit(pos->bitboards[promocao ? promocao : peca], destino);
+    setBit(pos->bitboards[peca], origem);
+    pos->peca_na_casa[destino] = SEM_PECA;
+    pos->peca_na_casa[origem] = peca;
+
+    // as ocupações mudam só nas casas tocadas pelo lance
+    pos->ocupacoes[pos->lado_a_jogar] ^= (1ULL << origem) | (1ULL << destino);
+
+    // recoloca a peça capturada (no en passant ela está atrás do destino)
+    if (desfazer->peca_capturada != -1)
+    {
+        int casa_captura = destino;
+
+        if (get_en_passant(lance))
+        {
+            casa_captura = (pos->lado_a_jogar == branco) ? destino - 8 : destino + 8;
         }
 
-        clearBit(ataques, destino);
+        setBit(pos->bitboards[desfazer->peca_capturada], casa_captura);
+        setBit(pos->ocupacoes[pos->lado_a_jogar ^ 1], casa_captura);
+        pos->peca_na_casa[casa_captura] = desfazer->peca_capturada;
     }
 
-    // En passant
-    if (en_passant != -999 && origem >= a5 && origem <= h5)
+    // devolve a torre do roque
+    if (get_roque(lance))
     {
-        if ((origem % 8 != 0 && en_passant == origem + 7) ||
-            (origem % 8 != 7 && en_passant == origem + 9))
+        switch (destino)
         {
-            adicionarLance(listaLances, codificar_lance(origem, en_passant, P, 0, 1, 0, 1, 0));
+        case g1:
+            clearBit(pos->bitboards[R], f1);
+            setBit(pos->bitboards[R], h1);
+            pos->peca_na_casa[f1] = SEM_PECA;
+            pos->peca_na_casa[h1] = R;
+            pos->ocupacoes[branco] ^= (1ULL << f1) | (1ULL << h1);
+            break;
+        case c1:
+            clearBit(pos->bitboards[R], d1);
+            setBit(pos->bitboards[R], a1);
+            pos->peca_na_casa[d1] = SEM_PECA;
+            pos->peca_na_casa[a1] = R;
+            pos->ocupacoes[branco] ^= (1ULL << d1) | (1ULL << a1);
+            break;
+        case g8:
+            clearBit(pos->bitboards[r], f8);
+            setBit(pos->bitboards[r], h8);
+            pos->peca_na_casa[f8] = SEM_PECA;
+            pos->peca_na_casa[h8] = r;
+            pos->ocupacoes[preto] ^= (1ULL << f8) | (1ULL << h8);
+            break;
+        case c8:
+            clearBit(pos->bitboards[r], d8);
+            setBit(pos->bitboards[r], a8);
+            pos->peca_na_casa[d8] = SEM_PECA;
+            pos->peca_na_casa[a8] = r;
+            pos->ocupacoes[preto] ^= (1ULL << d8) | (1ULL << a8);
+            break;
         }
     }
+
+    pos->roque = desfazer->roque;
+    pos->en_passant = desfazer->en_passant;
+    pos->hash_chave = desfazer->hash;
+
+    pos->ocupacoes[ambos] = pos->ocupacoes[branco] | pos->ocupacoes[preto];
 }
 
-// Função auxiliar para gerar movimentos de peões pretos
-void gerar_movimentos_peao_preto(int origem, lances *listaLances)
+void fazer_lance_nulo(posicao_t *pos, registro_desfazer *desfazer)
 {
-    int destino = origem - 8;
+    desfazer->peca_capturada = -1;
+    desfazer->roque = pos->roque;
+    desfazer->en_passant = pos->en_passant;
+    desfazer->hash = pos->hash_chave;
 
-    // Movimento simples
-    if (destino >= 0 && !getBit(ocupacoes[ambos], destino))
+    if (pos->en_passant != -999)
     {
-        if (origem >= a2 && origem <= h2)
-        { // 2ª linha (promoção para peões pretos)
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, q, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, r, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, b, 0, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, n, 0, 0, 0, 0));
-        }
-        else
-        {
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, 0, 0, 0, 0, 0));
+        pos->hash_chave ^= chaves_en_passant[pos->en_passant % 8];
+        pos->en_passant = -999;
+    }
+
+    pos->lado_a_jogar ^= 1;
+    pos->hash_chave ^= chave_lado;
+}
+
+void desfazer_lance_nulo(posicao_t *pos, registro_desfazer *desfazer)
+{
+    pos->lado_a_jogar ^= 1;
+    pos->en_passant = desfazer->en_passant;
+    pos->hash_chave = desfazer->hash;
+}
+
+// =============================================================================
+// STATIC EXCHANGE EVALUATION (SEE)
+// =============================================================================
+
+/**
+ * @brief Valores das peças usados pela SEE (mesma escala de material_score)
+ */
+static const int valor_see[12] = {
+    100, 320, 330, 500, 900, 20000,
+    100, 320, 330, 500, 900, 20000
+};
+
+int see(const posicao_t *pos, int lance)
+{
+    int origem = get_origem(lance);
+    int destino = get_destino(lance);
+    int peca = get_peca(lance);
+    int promocao = get_peca_promovida(lance);
+
+    int ganho[32];
+    int d = 0;
+    u64 ocupacao = pos->ocupacoes[ambos];
+
+    // Material ganho pelo primeiro lance
+    ganho[0] = 0;
+    if (get_en_passant(lance))
+    {
+        ganho[0] = valor_see[P];
+        clearBit(ocupacao, (pos->lado_a_jogar == branco) ? destino - 8 : destino + 8);
+    }
+    else if (pos->peca_na_casa[destino] != SEM_PECA)
+    {
+        ganho[0] = valor_see[pos->peca_na_casa[destino]];
+    }
+
+    // Peça que fica no destino e pode ser recapturada
+    int valor_na_casa = valor_see[peca];
+    if (promocao)
+    {
+        ganho[0] += valor_see[promocao] - valor_see[P];
+        valor_na_casa = valor_see[promocao];
+    }
+
+    u64 deslizantes_diagonais = pos->bitboards[B] | pos->bitboards[b] | pos->bitboards[Q] | pos->bitboards[q];
+    u64 deslizantes_retos = pos->bitboards[R] | pos->bitboards[r] | pos->bitboards[Q] | pos->bitboards[q];
+
+    u64 de = 1ULL << origem;
+    u64 atacantes = atacantes_casa(pos, destino, branco, ocupacao) | atacantes_casa(pos, destino, preto, ocupacao);
+    int lado = pos->lado_a_jogar;
 
-            // Movimento duplo do peão (da 7ª linha para peões pretos)
-            if (origem >= a7 && origem <= h7)
+    while (de)
+    {
+        d++;
+        lado ^= 1;
+
+        // Ganho se o lado da vez recapturar, sem considerar o que vem depois
+        ganho[d] = valor_na_casa - ganho[d - 1];
+
+        // Nenhum dos lados melhora continuando a troca
+        if ((-ganho[d - 1] > ganho[d] ? -ganho[d - 1] : ganho[d]) < 0 || d == 31)
+            break;
+
+        // Remove o atacante e descobre deslizantes que estavam atrás dele (raios-x)
+        ocupacao ^= de;
+        atacantes |= (obterAtaquesBispo(destino, ocupacao) & deslizantes_diagonais) |
+                     (obterAtaquesTorre(destino, ocupacao) & deslizantes_retos);
+        atacantes &= ocupacao;
+
+        // Próximo atacante: o de menor valor do lado da vez
+        de = 0ULL;
+        int base = (lado == branco) ? P : p;
+        for (int atacante = base; atacante <= base + 5; atacante++)
+        {
+            u64 candidatos = atacantes & pos->bitboards[atacante];
+            if (candidatos)
             {
-                destino = origem - 16;
-                if (destino >= 0 && !getBit(ocupacoes[ambos], destino))
-                {
-                    adicionarLance(listaLances, codificar_lance(origem, destino, p, 0, 0, 1, 0, 0));
-                }
+                de = candidatos & -candidatos;
+                valor_na_casa = valor_see[atacante];
+                break;
             }
         }
     }
 
-    // Capturas
-    u64 ataques = tabela_ataques_peao[preto][origem] & ocupacoes[branco];
-    while (ataques)
+    // Minimax de trás para frente: cada lado pode parar a troca quando quiser
+    while (--d)
     {
-        destino = getLeastBitIndex(ataques);
-
-        if (origem >= a2 && origem <= h2)
-        { // 2ª linha (promoção para peões pretos)
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, q, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, r, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, b, 1, 0, 0, 0));
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, n, 1, 0, 0, 0));
-        }
-        else
-        {
-            adicionarLance(listaLances, codificar_lance(origem, destino, p, 0, 1, 0, 0, 0));
-        }
+        ganho[d - 1] = -((-ganho[d - 1] > ganho[d]) ? -ganho[d - 1] : ganho[d]);
+    }
+
+    return ganho[0];
+}
+
+// =============================================================================
+// LEGALIDADE (XEQUES, CRAVADAS E EVASÕES)
+// =============================================================================
 
-        clearBit(ataques, destino);
+/**
+ * @brief Informações de xeque do lado a jogar, calculadas uma vez por posição
+ */
+typedef struct {
+    int rei;        ///< Casa do rei do lado a jogar
+    u64 atacantes;  ///< Peças do oponente que dão xeque
+    u64 cravadas;   ///< Peças do lado a jogar cravadas contra o próprio rei
+    u64 evasao;     ///< Destinos permitidos às outras peças (todas as casas sem xeque)
+} info_legalidade;
+
+static void calcular_info_legalidade(const posicao_t *pos, info_legalidade *info)
+{
+    int lado = pos->lado_a_jogar;
+    int oponente = lado ^ 1;
+    int base = (oponente == branco) ? P : p;
+
+    info->rei = getLeastBitIndex(pos->bitboards[(lado == branco) ? K : k]);
+    info->atacantes = atacantes_casa(pos, info->rei, oponente, pos->ocupacoes[ambos]);
+    info->cravadas = 0ULL;
+
+    // Deslizantes que veriam o rei se só houvesse peças do oponente no caminho
+    u64 damas = pos->bitboards[base + 4];
+    u64 candidatos = (obterAtaquesBispo(info->rei, pos->ocupacoes[oponente]) & (pos->bitboards[base + 2] | damas)) |
+                     (obterAtaquesTorre(info->rei, pos->ocupacoes[oponente]) & (pos->bitboards[base + 3] | damas));
+
+    while (candidatos)
+    {
+        int casa = getLeastBitIndex(candidatos);
+        u64 entre = casas_entre[info->rei][casa] & pos->ocupacoes[ambos];
+
+        // Exatamente uma peça entre o rei e o deslizante, e ela é nossa
+        if (entre && !(entre & (entre - 1)) && (entre & pos->ocupacoes[lado]))
+            info->cravadas |= entre;
+
+        clearBit(candidatos, casa);
     }
 
-    // En passant
-    if (en_passant != -999 && origem >= a4 && origem <= h4)
+    if (!info->atacantes)
     {
-        if ((origem % 8 != 0 && en_passant == origem - 9) ||
-            (origem % 8 != 7 && en_passant == origem - 7))
-        {
-            adicionarLance(listaLances, codificar_lance(origem, en_passant, p, 0, 1, 0, 1, 0));
-        }
+        info->evasao = ~0ULL;
+    }
+    else if (info->atacantes & (info->atacantes - 1))
+    {
+        info->evasao = 0ULL; // xeque duplo: só o rei pode se mover
+    }
+    else
+    {
+        // Capturar o atacante ou bloquear a linha do xeque
+        int atacante = getLeastBitIndex(info->atacantes);
+        info->evasao = info->atacantes | casas_entre[info->rei][atacante];
     }
 }
 
-// Função auxiliar para gerar roque branco
-void gerar_roque_branco(lances *listaLances)
+static int lance_legal(const posicao_t *pos, const info_legalidade *info, int lance)
 {
-    // Roque pequeno
-    if (roque & reiBranco_alaRei)
+    int origem = get_origem(lance);
+    int destino = get_destino(lance);
+    int oponente = pos->lado_a_jogar ^ 1;
+
+    if (origem == info->rei)
     {
-        if (!getBit(ocupacoes[ambos], f1) && !getBit(ocupacoes[ambos], g1))
-        {
-            if (!casaEstaAtacada(e1, preto) && !casaEstaAtacada(f1, preto) && !casaEstaAtacada(g1, preto))
-            {
-                adicionarLance(listaLances, codificar_lance(e1, g1, K, 0, 0, 0, 0, 1));
-            }
-        }
+        // Roque: casas de passagem já verificadas em gerar_roques()
+        if (get_roque(lance))
+            return 1;
+
+        // Sem o rei na ocupação, um deslizante continua atacando a casa atrás dele
+        u64 ocupacao = pos->ocupacoes[ambos] ^ (1ULL << origem);
+        return atacantes_casa(pos, destino, oponente, ocupacao) == 0ULL;
     }
 
-    // Roque grande
-    if (roque & reiBranco_alaDama)
+    if (get_en_passant(lance))
     {
-        if (!getBit(ocupacoes[ambos], b1) && !getBit(ocupacoes[ambos], c1) && !getBit(ocupacoes[ambos], d1))
-        {
-            if (!casaEstaAtacada(e1, preto) && !casaEstaAtacada(d1, preto) && !casaEstaAtacada(c1, preto))
-            {
-                adicionarLance(listaLances, codificar_lance(e1, c1, K, 0, 0, 0, 0, 1));
-            }
-        }
+        // Dois peões saem da mesma linha: testa a posição resultante
+        int casa_capturada = (pos->lado_a_jogar == branco) ? destino - 8 : destino + 8;
+        u64 ocupacao = pos->ocupacoes[ambos] ^ (1ULL << origem) ^ (1ULL << destino) ^ (1ULL << casa_capturada);
+        return (atacantes_casa(pos, info->rei, oponente, ocupacao) & ~(1ULL << casa_capturada)) == 0ULL;
     }
+
+    if (!getBit(info->evasao, destino))
+        return 0;
+
+    if (getBit(info->cravadas, origem) && !getBit(linha_casas[info->rei][origem], destino))
+        return 0;
+
+    return 1;
 }
 
-// Função auxiliar para gerar roque preto
-void gerar_roque_preto(lances *listaLances)
+// Remove da lista os lances que deixariam o próprio rei em xeque
+static void filtrar_lances_legais(const posicao_t *pos, const info_legalidade *info, lances *listaLances)
 {
-    // Roque pequeno
-    if (roque & reiPreto_alaRei)
+    int legais = 0;
+
+    for (int i = 0; i < listaLances->contador; i++)
     {
-        if (!getBit(ocupacoes[ambos], f8) && !getBit(ocupacoes[ambos], g8))
-        {
-            if (!casaEstaAtacada(e8, branco) && !casaEstaAtacada(f8, branco) && !casaEstaAtacada(g8, branco))
-            {
-                adicionarLance(listaLances, codificar_lance(e8, g8, k, 0, 0, 0, 0, 1));
-            }
-        }
+        int lance = listaLances->lances[i];
+
+        if (lance_legal(pos, info, lance))
+            listaLances->lances[legais++] = lance;
     }
 
-    // Roque grande
-    if (roque & reiPreto_alaDama)
+    listaLances->contador = legais;
+}
+
+// =============================================================================
+// GERAÇÃO DE LANCES ESPECIALIZADA POR LADO
+// =============================================================================
+//
+// O gerador é escrito uma única vez com o lado como constante e instanciado
+// para brancas e pretas: com SEMPRE_INLINE o compilador propaga 'lado',
+// 'tipo' e 'tipos' e elimina todos os testes de cor e de tipo de peça.
+// Os peões são gerados em conjunto, deslocando o bitboard inteiro.
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SEMPRE_INLINE static inline __attribute__((always_inline))
+#else
+#define SEMPRE_INLINE static inline
+#endif
+
+#define COLUNA_A 0x0101010101010101ULL
+#define COLUNA_H 0x8080808080808080ULL
+#define LINHA_2 0x000000000000FF00ULL
+#define LINHA_3 0x0000000000FF0000ULL
+#define LINHA_6 0x0000FF0000000000ULL
+#define LINHA_7 0x00FF000000000000ULL
+
+// Tipos de lance pedidos ao gerador
+enum { GERAR_CAPTURAS = 1, GERAR_QUIETOS = 2, GERAR_TODOS = 3 };
+
+// Desloca o bitboard 'casas' casas para a frente do lado
+SEMPRE_INLINE u64 avancar(u64 bitboard, const int lado, const int casas)
+{
+    return (lado == branco) ? bitboard << casas : bitboard >> casas;
+}
+
+SEMPRE_INLINE void empilhar_lance(lances *listaLances, int lance)
+{
+    if (listaLances->contador < 256)
+        listaLances->lances[listaLances->contador++] = lance;
+}
+
+// Um lance para cada destino, todos a partir da mesma origem
+SEMPRE_INLINE void adicionar_destinos(lances *listaLances, int origem, u64 destinos, int peca, u64 inimigas)
+{
+    while (destinos)
     {
-        if (!getBit(ocupacoes[ambos], b8) && !getBit(ocupacoes[ambos], c8) && !getBit(ocupacoes[ambos], d8))
-        {
-            if (!casaEstaAtacada(e8, branco) && !casaEstaAtacada(d8, branco) && !casaEstaAtacada(c8, branco))
-            {
-                adicionarLance(listaLances, codificar_lance(e8, c8, k, 0, 0, 0, 0, 1));
-            }
-        }
+        int destino = getLeastBitIndex(destinos);
+        int captura = (int)((inimigas >> destino) & 1ULL);
+        empilhar_lance(listaLances, codificar_lance(origem, destino, peca, 0, captura, 0, 0, 0));
+        clearBit(destinos, destino);
     }
 }
 
-// Função genérica para gerar movimentos de peças "grandes" (cavalos, bispos, torres, damas)
-void gerar_movimentos_pecaGrande(int origem, int lado, int tipo_peca, lances *listaLances)
+// Um lance por destino, com a origem a 'deslocamento' casas atrás (peões)
+SEMPRE_INLINE void adicionar_lances_peao(lances *listaLances, u64 destinos, int deslocamento, const int lado, int captura, int duplo)
 {
-    u64 ataques;
+    const int peao = (lado == branco) ? P : p;
 
-    // Obtém os ataques baseado no tipo da peça
-    switch (tipo_peca)
+    while (destinos)
     {
-    case N:
-    case n:
-        ataques = tabela_ataques_cavalo[origem];
-        break;
-    case B:
-    case b:
-        ataques = obterAtaquesBispo(origem, ocupacoes[ambos]);
-        break;
-    case R:
-    case r:
-        ataques = obterAtaquesTorre(origem, ocupacoes[ambos]);
-        break;
-    case Q:
-    case q:
-        ataques = obterAtaquesDama(origem, ocupacoes[ambos]);
-        break;
-    case K:
-    case k:
-        ataques = tabela_ataques_rei[origem];
-        break;
-    default:
-        return; // Tipo de peça inválido
+        int destino = getLeastBitIndex(destinos);
+        empilhar_lance(listaLances, codificar_lance(destino - deslocamento, destino, peao, 0, captura, duplo, 0, 0));
+        clearBit(destinos, destino);
     }
+}
 
-    // Remove casas ocupadas pelo próprio lado
-    ataques &= ~ocupacoes[lado];
-    u64 ocupacao_oponente = (lado == branco) ? ocupacoes[preto] : ocupacoes[branco];
+SEMPRE_INLINE void adicionar_promocoes(lances *listaLances, u64 destinos, int deslocamento, const int lado, int captura)
+{
+    const int peao = (lado == branco) ? P : p;
 
-    while (ataques)
+    while (destinos)
     {
-        int destino = getLeastBitIndex(ataques);
+        int destino = getLeastBitIndex(destinos);
+        int origem = destino - deslocamento;
 
-        if (getBit(ocupacao_oponente, destino))
-        {
-            adicionarLance(listaLances, codificar_lance(origem, destino, tipo_peca, 0, 1, 0, 0, 0));
-        }
-        else
+        // Dama, torre, bispo e cavalo
+        for (int promocao = peao + dama; promocao > peao; promocao--)
         {
-            adicionarLance(listaLances, codificar_lance(origem, destino, tipo_peca, 0, 0, 0, 0, 0));
+            empilhar_lance(listaLances, codificar_lance(origem, destino, peao, promocao, captura, 0, 0, 0));
         }
 
-        clearBit(ataques, destino);
+        clearBit(destinos, destino);
     }
 }
 
-int fazer_lance(int lance, int flag, estado_jogo backup)
+// Peões: avanços, capturas e promoções de todos os peões de uma vez.
+// 'alvos' restringe os destinos (tipos pedidos e máscara de evasão).
+SEMPRE_INLINE void gerar_peoes(const posicao_t *pos, const int lado, const int tipos, u64 alvos, lances *listaLances)
 {
-
-    if (flag == todosLances)
+    const int peao = (lado == branco) ? P : p;
+    const int frente = (lado == branco) ? 8 : -8;
+    const int esquerda = (lado == branco) ? 7 : 9;  // captura em direção à coluna a
+    const int direita = (lado == branco) ? 9 : 7;   // captura em direção à coluna h
+    const u64 linha_promocao = (lado == branco) ? LINHA_7 : LINHA_2;
+    const u64 linha_duplo = (lado == branco) ? LINHA_3 : LINHA_6; // casa intermediária do avanço duplo
+
+    u64 peoes = pos->bitboards[peao];
+    u64 normais = peoes & ~linha_promocao;
+    u64 promovendo = peoes & linha_promocao;
+
+    if (tipos & GERAR_QUIETOS)
     {
+        u64 vazias = ~pos->ocupacoes[ambos];
+        u64 simples = avancar(normais, lado, 8) & vazias;
+        u64 duplos = avancar(simples & linha_duplo, lado, 8) & vazias & alvos;
 
-        SALVAR_ESTADO(backup);
+        adicionar_lances_peao(listaLances, simples & alvos, frente, lado, 0, 0);
+        adicionar_lances_peao(listaLances, duplos, 2 * frente, lado, 0, 1);
+        adicionar_promocoes(listaLances, avancar(promovendo, lado, 8) & vazias & alvos, frente, lado, 0);
+    }
 
-        int origem = get_origem(lance);
-        int destino = get_destino(lance);
-        int peca = get_peca(lance);
-        int promocao = get_peca_promovida(lance);
-        int captura = get_captura(lance);
-        int movimento_duplo = get_double_push(lance);
-        int en_passant_flag = get_en_passant(lance);
-        int roque_flag = get_roque(lance);
+    if (tipos & GERAR_CAPTURAS)
+    {
+        u64 inimigas = pos->ocupacoes[lado ^ 1] & alvos;
+        const int desloc_esquerda = (lado == branco) ? esquerda : -esquerda;
+        const int desloc_direita = (lado == branco) ? direita : -direita;
 
-        clearBit(bitboards[peca], origem);
-        setBit(bitboards[peca], destino);
+        adicionar_lances_peao(listaLances, avancar(normais & ~COLUNA_A, lado, esquerda) & inimigas, desloc_esquerda, lado, 1, 0);
+        adicionar_lances_peao(listaLances, avancar(normais & ~COLUNA_H, lado, direita) & inimigas, desloc_direita, lado, 1, 0);
+        adicionar_promocoes(listaLances, avancar(promovendo & ~COLUNA_A, lado, esquerda) & inimigas, desloc_esquerda, lado, 1);
+        adicionar_promocoes(listaLances, avancar(promovendo & ~COLUNA_H, lado, direita) & inimigas, desloc_direita, lado, 1);
 
-        if (captura)
+        // En passant fica fora de 'alvos': lance_legal() testa a posição resultante
+        if (pos->en_passant != -999)
         {
-            int pecaInicial, pecaFinal;
-            if (lado_a_jogar == branco)
+            u64 atacantes = tabela_ataques_peao[lado ^ 1][pos->en_passant] & normais;
+            while (atacantes)
             {
-                pecaInicial = p;
-                pecaFinal = k;
-            }
-            else
-            {
-                pecaInicial = P;
-                pecaFinal = K;
-            }
-            for (int peca = pecaInicial; peca <= pecaFinal; peca++)
-            {
-                if (getBit(bitboards[peca], destino))
-                {
-                    clearBit(bitboards[peca], destino);
-                    break;
-                }
+                int origem = getLeastBitIndex(atacantes);
+                empilhar_lance(listaLances, codificar_lance(origem, pos->en_passant, peao, 0, 1, 0, 1, 0));
+                clearBit(atacantes, origem);
             }
         }
+    }
+}
 
-        if (promocao)
-        {
-            if ( lado_a_jogar == branco) {
-                clearBit(bitboards[P], destino);
-            } else {
-                clearBit(bitboards[p], destino);
-            }
+// Cavalos, bispos, torres, damas ou rei ('tipo' = cavalo..rei)
+SEMPRE_INLINE void gerar_pecas(const posicao_t *pos, const int lado, const int tipo, u64 alvos, lances *listaLances)
+{
+    const int peca = ((lado == branco) ? P : p) + tipo;
+    u64 inimigas = pos->ocupacoes[lado ^ 1];
+    u64 ocupacao = pos->ocupacoes[ambos];
+    u64 bitboardCopia = pos->bitboards[peca];
 
-            setBit(bitboards[promocao], destino);
-        }
+    while (bitboardCopia)
+    {
+        int origem = getLeastBitIndex(bitboardCopia);
+        u64 ataques;
+
+        if (tipo == cavalo)
+            ataques = tabela_ataques_cavalo[origem];
+        else if (tipo == bispo)
+            ataques = obterAtaquesBispo(origem, ocupacao);
+        else if (tipo == torre)
+            ataques = obterAtaquesTorre(origem, ocupacao);
+        else if (tipo == dama)
+            ataques = obterAtaquesDama(origem, ocupacao);
+        else
+            ataques = tabela_ataques_rei[origem];
 
-        if(en_passant_flag) {
-            if (lado_a_jogar == branco) {
-                clearBit(bitboards[p], destino - 8);
-            } else {
-                clearBit(bitboards[P], destino + 8);
-            }
-        }   
+        adicionar_destinos(listaLances, origem, ataques & alvos, peca, inimigas);
+        clearBit(bitboardCopia, origem);
+    }
+}
 
-        en_passant = -999;
+// Roques: as casas das pretas são as das brancas oito linhas acima
+SEMPRE_INLINE void gerar_roques(const posicao_t *pos, const int lado, lances *listaLances)
+{
+    const int rei = (lado == branco) ? K : k;
+    const int linha = (lado == branco) ? 0 : 56;
+    const int oponente = lado ^ 1;
+    const int direito_ala_rei = (lado == branco) ? reiBranco_alaRei : reiPreto_alaRei;
+    const int direito_ala_dama = (lado == branco) ? reiBranco_alaDama : reiPreto_alaDama;
+    u64 ocupacao = pos->ocupacoes[ambos];
 
-        if (movimento_duplo)
+    // Roque pequeno
+    if ((pos->roque & direito_ala_rei) && !getBit(ocupacao, f1 + linha) && !getBit(ocupacao, g1 + linha))
+    {
+        if (!casaEstaAtacada(pos, e1 + linha, oponente) && !casaEstaAtacada(pos, f1 + linha, oponente) && !casaEstaAtacada(pos, g1 + linha, oponente))
         {
-            if (lado_a_jogar == branco)
-            {
-                en_passant = origem + 8;
-            }
-            else
-            {
-                en_passant = origem - 8;
-            }
+            empilhar_lance(listaLances, codificar_lance(e1 + linha, g1 + linha, rei, 0, 0, 0, 0, 1));
         }
+    }
 
-        if (roque_flag)
+    // Roque grande
+    if ((pos->roque & direito_ala_dama) && !getBit(ocupacao, b1 + linha) && !getBit(ocupacao, c1 + linha) && !getBit(ocupacao, d1 + linha))
+    {
+        if (!casaEstaAtacada(pos, e1 + linha, oponente) && !casaEstaAtacada(pos, d1 + linha, oponente) && !casaEstaAtacada(pos, c1 + linha, oponente))
         {
-            if (lado_a_jogar == branco)
-            {
-                // Roque pequeno
-                if (destino == g1)
-                {
-                    clearBit(bitboards[R], h1);
-                    setBit(bitboards[R], f1);
-                }
-                // Roque grande
-                else if (destino == c1)
-                {
-                    clearBit(bitboards[R], a1);
-                    setBit(bitboards[R], d1);
-                }
-            }
-            else
-            {
-                // Roque pequeno
-                if (destino == g8)
-                {
-                    clearBit(bitboards[r], h8);
-                    setBit(bitboards[r], f8);
-                }
-                // Roque grande
-                else if (destino == c8)
-                {
-                    clearBit(bitboards[r], a8);
-                    setBit(bitboards[r], d8);
-                }
-            }
+            empilhar_lance(listaLances, codificar_lance(e1 + linha, c1 + linha, rei, 0, 0, 0, 0, 1));
         }
+    }
+}
 
-        //roque
-        roque &= roque_permissoes[origem];
-        roque &= roque_permissoes[destino];
+// Gerador completo de um lado; 'tipos' escolhe capturas, quietos ou ambos
+SEMPRE_INLINE void gerar_lances_lado(const posicao_t *pos, const int lado, const int tipos, lances *listaLances)
+{
+    listaLances->contador = 0;
 
-        // ocupacoes
-        memset(ocupacoes, 0ULL, sizeof(ocupacoes));
-        for (int peca = P; peca <= k; peca++){
-            ocupacoes[peca <= K ? branco : preto] |= bitboards[peca];
-        }
-        ocupacoes[ambos] |= ocupacoes[branco];
-        ocupacoes[ambos] |= ocupacoes[preto];
+    info_legalidade info;
+    calcular_info_legalidade(pos, &info);
 
-        // mudar lado a jogar
-        lado_a_jogar ^= 1; 
+    u64 alvos = 0ULL;
+    if (tipos & GERAR_CAPTURAS)
+        alvos |= pos->ocupacoes[lado ^ 1];
+    if (tipos & GERAR_QUIETOS)
+        alvos |= ~pos->ocupacoes[ambos];
 
-        // verificar se o rei do lado que acabou de jogar ficou em cheque
-        if(casaEstaAtacada((lado_a_jogar == branco) ? getLeastBitIndex(bitboards[k]) : getLeastBitIndex(bitboards[K]), lado_a_jogar)) {
-            // o rei ficou em cheque, desfaz o lance
-            RESTAURAR_ESTADO(backup);
-            return 0;
-        } else {
-            return 1;
-        }
+    // Em xeque duplo (evasão vazia) só o rei se move; em xeque simples as
+    // demais peças só podem ir para as casas da máscara de evasão
+    if (info.evasao)
+    {
+        u64 alvos_pecas = alvos & info.evasao;
 
+        gerar_peoes(pos, lado, tipos, alvos_pecas, listaLances);
+        gerar_pecas(pos, lado, cavalo, alvos_pecas, listaLances);
+        gerar_pecas(pos, lado, bispo, alvos_pecas, listaLances);
+        gerar_pecas(pos, lado, torre, alvos_pecas, listaLances);
+        gerar_pecas(pos, lado, dama, alvos_pecas, listaLances);
     }
+
+    if ((tipos & GERAR_QUIETOS) && !info.atacantes)
+        gerar_roques(pos, lado, listaLances);
+
+    gerar_pecas(pos, lado, rei, alvos, listaLances);
+
+    filtrar_lances_legais(pos, &info, listaLances);
+}
+
+void gerar_lances(const posicao_t *pos, lances *listaLances)
+{
+    if (pos->lado_a_jogar == branco)
+        gerar_lances_lado(pos, branco, GERAR_TODOS, listaLances);
+    else
+        gerar_lances_lado(pos, preto, GERAR_TODOS, listaLances);
+}
+
+void gerar_capturas(const posicao_t *pos, lances *listaLances)
+{
+    if (pos->lado_a_jogar == branco)
+        gerar_lances_lado(pos, branco, GERAR_CAPTURAS, listaLances);
     else
+        gerar_lances_lado(pos, preto, GERAR_CAPTURAS, listaLances);
+}
+
+void gerar_quietos(const posicao_t *pos, lances *listaLances)
+{
+    if (pos->lado_a_jogar == branco)
+        gerar_lances_lado(pos, branco, GERAR_QUIETOS, listaLances);
+    else
+        gerar_lances_lado(pos, preto, GERAR_QUIETOS, listaLances);
+}
+
+int lance_valido(const posicao_t *pos, int lance)
+{
+    if (!lance)
+        return 0;
+
+    int origem = get_origem(lance);
+    int destino = get_destino(lance);
+    int peca = get_peca(lance);
+    int promocao = get_peca_promovida(lance);
+    int lado = pos->lado_a_jogar;
+    int base = (lado == branco) ? P : p;
+
+    // A peça tem que ser do lado a jogar e estar na origem
+    if (peca < base || peca > base + 5 || !getBit(pos->bitboards[peca], origem))
+        return 0;
+
+    if (getBit(pos->ocupacoes[lado], destino))
+        return 0;
+
+    // A flag de captura tem que bater com o conteúdo do destino
+    int captura = getBit(pos->ocupacoes[lado ^ 1], destino) != 0;
+    if (get_en_passant(lance))
+    {
+        if (peca != base || destino != pos->en_passant || !getBit(tabela_ataques_peao[lado][origem], destino))
+            return 0;
+    }
+    else if ((get_captura(lance) != 0) != captura)
+    {
+        return 0;
+    }
+
+    if (get_roque(lance))
+    {
+        // Raro o bastante para simplesmente gerar os roques da posição
+        lances roques;
+        roques.contador = 0;
+        gerar_roques(pos, lado, &roques);
+
+        for (int i = 0; i < roques.contador; i++)
+        {
+            if (roques.lances[i] == lance)
+                return 1; // gerar_roques() já garante que o rei não passa por xeque
+        }
+        return 0;
+    }
+
+    if (peca == base)
     {
+        int direcao = (lado == branco) ? 8 : -8;
+        int ultima_linha = (lado == branco) ? 7 : 0;
+
+        // Promoção obrigatória ao chegar na última linha, para uma peça do próprio lado
+        if ((destino / 8 == ultima_linha) != (promocao != 0))
+            return 0;
+        if (promocao && (promocao <= base || promocao >= base + 5))
+            return 0;
+
         if (get_captura(lance))
         {
-            fazer_lance(lance, todosLances, backup);
+            if (!getBit(tabela_ataques_peao[lado][origem], destino))
+                return 0;
         }
-        else
+        else if (get_double_push(lance))
+        {
+            int linha_inicial = (lado == branco) ? 1 : 6;
+            if (origem / 8 != linha_inicial || destino != origem + 2 * direcao ||
+                getBit(pos->ocupacoes[ambos], origem + direcao) || getBit(pos->ocupacoes[ambos], destino))
+                return 0;
+        }
+        else if (destino != origem + direcao || getBit(pos->ocupacoes[ambos], destino))
         {
             return 0;
         }
     }
-
-
-}
-
-void gerar_lances(lances *listaLances)
-{
-    listaLances->contador = 0;
-
-    for (int peca = P; peca <= k; peca++)
+    else
     {
-        if (!bitboards[peca])
-            continue; // Pula se não há peças deste tipo
+        if (promocao || get_double_push(lance))
+            return 0;
 
-        if (lado_a_jogar == branco)
+        u64 ataques;
+        switch (peca - base)
         {
-            if (peca == P)
-            {
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_peao_branco(origem, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
-            else if (peca == K)
-            {
-                gerar_roque_branco(listaLances);
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_pecaGrande(origem, branco, peca, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
-            else if (peca == N || peca == B || peca == R || peca == Q )
-            {
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_pecaGrande(origem, branco, peca, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
-        }
-        else
-        { // lado_a_jogar == preto
-            if (peca == p)
-            {
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_peao_preto(origem, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
-            else if (peca == k)
-            {
-                gerar_roque_preto(listaLances);
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_pecaGrande(origem, preto, peca, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
-            else if (peca == n || peca == b || peca == r || peca == q)
-            {
-                u64 bitboardCopia = bitboards[peca];
-                while (bitboardCopia)
-                {
-                    int origem = getLeastBitIndex(bitboardCopia);
-                    gerar_movimentos_pecaGrande(origem, preto, peca, listaLances);
-                    clearBit(bitboardCopia, origem);
-                }
-            }
+        case N:
+            ataques = tabela_ataques_cavalo[origem];
+            break;
+        case B:
+            ataques = obterAtaquesBispo(origem, pos->ocupacoes[ambos]);
+            break;
+        case R:
+            ataques = obterAtaquesTorre(origem, pos->ocupacoes[ambos]);
+            break;
+        case Q:
+            ataques = obterAtaquesDama(origem, pos->ocupacoes[ambos]);
+            break;
+        default:
+            ataques = tabela_ataques_rei[origem];
+            break;
         }
+
+        if (!getBit(ataques, destino))
+            return 0;
     }
+
+    info_legalidade info;
+    calcular_info_legalidade(pos, &info);
+
+    // Em xeque duplo só o rei se move (lance_legal confia no gerador para isso)
+    if (info.atacantes && !info.evasao && origem != info.rei)
+        return 0;
+
+    return lance_legal(pos, &info, lance);
 }
@@ -12,36 +12,13 @@
 #include "../include/bitboard.h"
 #include "../include/ataques.h"
 #include "../include/evaluate.h"
+#include "../include/globals.h"
+#include "../include/transposicao.h"
 #include <string.h>
-
-// =============================================================================
-// VARIÁVEIS GLOBAIS DO ESTADO DO JOGO
-// =============================================================================
-
-/**
- * @brief Bitboards para cada tipo de peça (12 peças: 6 brancas + 6 pretas)
- */
-u64 bitboards[12];
-
-/**
- * @brief Bitboards de ocupação [branco, preto, ambos]
- */
-u64 ocupacoes[3];
-
-/**
- * @brief Lado que deve jogar (0=branco, 1=preto)
- */
-int lado_a_jogar;
-
-/**
- * @brief Casa en passant disponível (-999 = nenhuma)
- */
-int en_passant = -999;
-
-/**
- * @brief Direitos de roque (bitfield)
- */
-int roque = 0;
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
 
 // =============================================================================
 // TABELAS DE CONFIGURAÇÃO
@@ -116,11 +93,6 @@ const char pecas_promocao[] = {
     [q] = 'q', [r] = 'r', [b] = 'b', [n] = 'n'
 };
 
-/**
- * @brief Contador de nós para função perft
- */
-long nos;
-
 // =============================================================================
 // FUNÇÕES DE VISUALIZAÇÃO E DEBUG
 // =============================================================================
@@ -169,7 +141,7 @@ void printBitboard(u64 bitboard)
  * Exibe o tabuleiro completo mostrando todas as peças em suas posições,
  * além de informações sobre turno, en passant, direitos de roque e score.
  */
-void printTabuleiro()
+void printTabuleiro(const posicao_t *pos)
 {
     for (int linha = 7; linha >= 0; linha--)
     {
@@ -179,17 +151,9 @@ void printTabuleiro()
         {
             int casa = linha * 8 + coluna;
 
-            int peca = -1;
+            int peca = pos->peca_na_casa[casa];
 
-            for (int pecaTabuleiro = P; pecaTabuleiro <= k; pecaTabuleiro++)
-            {
-                if (getBit(bitboards[pecaTabuleiro], casa))
-                {
-                    peca = pecaTabuleiro;
-                }
-            }
-
-            if (peca != -1)
+            if (peca != SEM_PECA)
             {
                 #ifdef _WIN32
                                 printf(" %c ", pecas_char[peca]);
@@ -209,19 +173,19 @@ void printTabuleiro()
 
     printf("\n");
 
-    printf("Turno das: %s\n", lado_a_jogar == branco ? "Brancas" : "Pretas");
+    printf("Turno das: %s\n", pos->lado_a_jogar == branco ? "Brancas" : "Pretas");
 
-    printf("En passant: %s\n", (en_passant != -999) ? casa_nome[en_passant] : "Nenhum");
+    printf("En passant: %s\n", (pos->en_passant != -999) ? casa_nome[pos->en_passant] : "Nenhum");
 
     printf("Roque: ");
 
-    printf("%c", (roque & reiBranco_alaRei)     ? 'K' : '-');
-    printf("%c", (roque & reiBranco_alaDama)    ? 'Q' : '-');
-    printf("%c", (roque & reiPreto_alaRei)      ? 'k' : '-');
-    printf("%c", (roque & reiPreto_alaDama)     ? 'q' : '-');
+    printf("%c", (pos->roque & reiBranco_alaRei)     ? 'K' : '-');
+    printf("%c", (pos->roque & reiBranco_alaDama)    ? 'Q' : '-');
+    printf("%c", (pos->roque & reiPreto_alaRei)      ? 'k' : '-');
+    printf("%c", (pos->roque & reiPreto_alaDama)     ? 'q' : '-');
     printf("\n");
 
-    printf("Score: %d\n", evaluate());
+    printf("Score: %d\n", evaluate(pos));
 }
 
 /**
@@ -232,7 +196,7 @@ void printTabuleiro()
  * 
  * @param lado Lado que ataca (branco ou preto)
  */
-void printCasasAtacadasPeloLado(int lado){
+void printCasasAtacadasPeloLado(const posicao_t *pos, int lado){
     printf("\n");
     
     // loop sobre as linhas do tabuleiro (de 7 para 0, igual ao printTabuleiro)
@@ -249,7 +213,7 @@ void printCasasAtacadasPeloLado(int lado){
                 printf("  %d ", linha + 1); // linha + 1 para mostrar 8, 7, 6...
             
             // verifica se a casa atual está atacada ou não
-            printf(" %d", casaEstaAtacada(casa, lado) ? 1 : 0);
+            printf(" %d", casaEstaAtacada(pos, casa, lado) ? 1 : 0);
         }
         
         // imprime nova linha a cada linha
@@ -272,13 +236,14 @@ void printCasasAtacadasPeloLado(int lado){
  * 
  * @param fen String FEN a ser analisada
  */
-void parseFEN(char *fen){
+void parseFEN(posicao_t *pos, char *fen){
     // Inicializa os bitboards e ocupações vazios e variaveis de estado do jogo
-    memset(bitboards, 0ULL, sizeof(bitboards));
-    memset(ocupacoes, 0ULL, sizeof(ocupacoes));
-    lado_a_jogar = branco;
-    en_passant = -999;
-    roque = 0;
+    memset(pos->bitboards, 0ULL, sizeof(pos->bitboards));
+    memset(pos->ocupacoes, 0ULL, sizeof(pos->ocupacoes));
+    memset(pos->peca_na_casa, SEM_PECA, sizeof(pos->peca_na_casa));
+    pos->lado_a_jogar = branco;
+    pos->en_passant = -999;
+    pos->roque = 0;
 
     // Cria mapeamento reverso usando seu pecas_char[] existente
     int char_para_peca[256];
@@ -309,7 +274,8 @@ void parseFEN(char *fen){
             else if(char_para_peca[*fen] != -1) {
                 // É uma peça válida
                 int peca = char_para_peca[*fen];
-                setBit(bitboards[peca], casa);
+                setBit(pos->bitboards[peca], casa);
+                pos->peca_na_casa[casa] = peca;
                 fen++;
             }
             else {
@@ -323,9 +289,9 @@ void parseFEN(char *fen){
     
     // 2. Parse do lado a jogar
     if(*fen == 'w') {
-        lado_a_jogar = branco;
+        pos->lado_a_jogar = branco;
     } else if(*fen == 'b') {
-        lado_a_jogar = preto;
+        pos->lado_a_jogar = preto;
     }
     fen++;
     
@@ -335,10 +301,10 @@ void parseFEN(char *fen){
     // 3. Parse do roque
     if(*fen != '-') {
         while(*fen != ' ' && *fen != '\0') {
-            if(*fen == 'K') roque |= reiBranco_alaRei;
-            else if(*fen == 'Q') roque |= reiBranco_alaDama;
-            else if(*fen == 'k') roque |= reiPreto_alaRei;
-            else if(*fen == 'q') roque |= reiPreto_alaDama;
+            if(*fen == 'K') pos->roque |= reiBranco_alaRei;
+            else if(*fen == 'Q') pos->roque |= reiBranco_alaDama;
+            else if(*fen == 'k') pos->roque |= reiPreto_alaRei;
+            else if(*fen == 'q') pos->roque |= reiPreto_alaDama;
             fen++;
         }
     } else {
@@ -355,20 +321,23 @@ void parseFEN(char *fen){
         fen++;
         int linha = *fen - '1';   // '1' = 0, '2' = 1, etc.
         fen++;
-        en_passant = linha * 8 + coluna;
+        pos->en_passant = linha * 8 + coluna;
     } else {
-        en_passant = -999;
+        pos->en_passant = -999;
         fen++; // Pula o '-'
     }
     
     // Atualizar ocupações
     for(int i = P; i <= K; i++) {
-        ocupacoes[branco] |= bitboards[i];
+        pos->ocupacoes[branco] |= pos->bitboards[i];
     }
     for(int i = p; i <= k; i++) {
-        ocupacoes[preto] |= bitboards[i];
+        pos->ocupacoes[preto] |= pos->bitboards[i];
     }
-    ocupacoes[ambos] = ocupacoes[branco] | ocupacoes[preto];
+    pos->ocupacoes[ambos] = pos->ocupacoes[branco] | pos->ocupacoes[preto];
+
+    // Chave Zobrist calculada do zero; a partir daqui fazer_lance() a mantém
+    pos->hash_chave = gerar_chave_hash(pos);
 }
 
 int contarBits(u64 bitboard)
@@ -427,74 +396,336 @@ void printListaLances(lances *listaLances) {
     printf("Total de lances: %d\n", listaLances->contador);
 }
 
-void perft(int profundidade) {
+long perft(posicao_t *pos, int profundidade, atomic_int *parar) {
     if (profundidade == 0) {
-        nos++;
-        return;
+        return 1;
     }
 
+    long nos = 0;
     lances listaLances;
 
-    gerar_lances(&listaLances);
+    // "stop" durante "go perft": a contagem parcial é descartada por perft_divide()
+    if (parar && atomic_load_explicit(parar, memory_order_relaxed)) {
+        return 0;
+    }
+
+    // Subárvore já contada por outro caminho (transposição)
+    if (profundidade > 1 && sondar_tt_perft(pos->hash_chave, profundidade, &nos)) {
+        return nos;
+    }
+
+    gerar_lances(pos, &listaLances);
+
+    // Os lances gerados já são legais: na última camada basta contá-los
+    if (profundidade == 1) {
+        return listaLances.contador;
+    }
 
     for (int i = 0; i < listaLances.contador; i++) {
         int lance = listaLances.lances[i];
 
-        // Salva o estado atual
-        estado_jogo backup;
-        SALVAR_ESTADO(backup);
+        registro_desfazer desfazer;
 
-        if (!fazer_lance(lance, todosLances, backup)) {
-            continue; // Lance inválido, tenta o próximo
-        }
+        fazer_lance(pos, lance, todosLances, &desfazer);
+
+        nos += perft(pos, profundidade - 1, parar);
 
-        perft(profundidade - 1);
+        // Desfaz o lance
+        desfazer_lance(pos, lance, &desfazer);
+    }
 
-        // Restaura o estado anterior
-        RESTAURAR_ESTADO(backup);
+    // Contagem parcial de um perft interrompido não vai para a tabela
+    if (!parar || !atomic_load_explicit(parar, memory_order_relaxed)) {
+        gravar_tt_perft(pos->hash_chave, profundidade, nos);
     }
 
+    return nos;
 }   
 
-void perft_teste(int profundidade) {
-    if (profundidade == 0) {
-        nos++;
-        return;
+// Trabalho compartilhado pelas threads do perft paralelo: cada thread pega o
+// próximo lance da raiz ainda não contado
+typedef struct {
+    posicao_t raiz;
+    int profundidade;
+    lances lances_raiz;
+    long nos_por_lance[256];
+    atomic_int proximo;
+    atomic_int *parar;
+} tarefa_perft;
+
+static void *executar_perft_thread(void *argumento) {
+    tarefa_perft *tarefa = (tarefa_perft *)argumento;
+    posicao_t pos = tarefa->raiz; // cada thread trabalha na própria cópia
+
+    int i;
+    while ((i = atomic_fetch_add(&tarefa->proximo, 1)) < tarefa->lances_raiz.contador) {
+        int lance = tarefa->lances_raiz.lances[i];
+        registro_desfazer desfazer;
+
+        fazer_lance(&pos, lance, todosLances, &desfazer);
+        tarefa->nos_por_lance[i] = perft(&pos, tarefa->profundidade - 1, tarefa->parar);
+        desfazer_lance(&pos, lance, &desfazer);
     }
 
-    lances listaLances;
-
-    gerar_lances(&listaLances);
+    return NULL;
+}
 
+long perft_divide(const posicao_t *pos, int profundidade, int num_threads, atomic_int *parar) {
     int inicio = get_tempo_milisegundos();
+    long nos = 0;
 
-    for (int i = 0; i < listaLances.contador; i++) {
-        int lance = listaLances.lances[i];
+    if (profundidade < 1) {
+        nos = 1;
+    } else {
+        tarefa_perft *tarefa = malloc(sizeof(tarefa_perft));
+        tarefa->raiz = *pos;
+        tarefa->profundidade = profundidade;
+        atomic_init(&tarefa->proximo, 0);
+        tarefa->parar = parar;
+        gerar_lances(pos, &tarefa->lances_raiz);
+
+        // Não adianta ter mais threads do que lances na raiz
+        if (num_threads > tarefa->lances_raiz.contador)
+            num_threads = tarefa->lances_raiz.contador;
+        if (num_threads < 1)
+            num_threads = 1;
+
+        // A thread chamadora também conta lances
+        pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+        for (int t = 1; t < num_threads; t++) {
+            pthread_create(&threads[t], NULL, executar_perft_thread, tarefa);
+        }
+        executar_perft_thread(tarefa);
+        for (int t = 1; t < num_threads; t++) {
+            pthread_join(threads[t], NULL);
+        }
+        free(threads);
 
-        // Salva o estado atual
-        estado_jogo backup;
-        SALVAR_ESTADO(backup);
+        if (parar && atomic_load(parar)) {
+            free(tarefa);
+            printf("Perft interrompido\n\n");
+            fflush(stdout);
+            return 0;
+        }
+
+        for (int i = 0; i < tarefa->lances_raiz.contador; i++) {
+            int lance = tarefa->lances_raiz.lances[i];
+            int promocao = get_peca_promovida(lance);
 
-        if (!fazer_lance(lance, todosLances, backup)) {
-            continue; // Lance inválido, tenta o próximo
+            printf("%s%s", casa_nome[get_origem(lance)], casa_nome[get_destino(lance)]);
+            if (promocao) {
+                printf("%c", pecas_promocao[promocao]);
+            }
+            printf(": %ld\n", tarefa->nos_por_lance[i]);
+
+            nos += tarefa->nos_por_lance[i];
         }
 
-        long nos_antes = nos;
+        free(tarefa);
+    }
 
-        perft(profundidade - 1);
+    int tempo = get_tempo_milisegundos() - inicio;
 
-        long nos_antigos = nos - nos_antes;
+    printf("\nProfundidade: %d\n", profundidade);
+    printf("Nos: %ld\n", nos);
+    printf("Tempo: %d ms\n", tempo);
+    printf("NPS: %ld\n", tempo > 0 ? nos * 1000 / tempo : 0);
+    printf("\n");
+    fflush(stdout);
 
-        // Restaura o estado anterior
-        RESTAURAR_ESTADO(backup);
-        printLance(lance);
-        printf("nos : %ld\n", nos_antigos);
+    return nos;
+}
 
+void perft_teste(posicao_t *pos, int profundidade) {
+    perft_divide(pos, profundidade, 1, NULL);
+}
+
+// =============================================================================
+// SUÍTE DE REGRESSÃO DO PERFT (EPD)
+// =============================================================================
+
+#define MAX_PROFUNDIDADES_SUITE 16
+
+// Uma linha da suíte: FEN e contagens esperadas ("D1 20 ;D2 400 ...")
+typedef struct {
+    char fen[256];
+    int num_profundidades;
+    int profundidades[MAX_PROFUNDIDADES_SUITE];
+    long esperados[MAX_PROFUNDIDADES_SUITE];
+} posicao_suite;
+
+// Posições da suíte divididas entre as threads, uma posição inteira por vez
+typedef struct {
+    posicao_suite *posicoes;
+    int num_posicoes;
+    atomic_int proxima;
+    atomic_int falhas;
+    atomic_long nos_total;
+    pthread_mutex_t saida; // uma linha de resultado por vez
+} tarefa_suite;
+
+// Número de núcleos disponíveis (1 se o sistema não informar)
+static int nucleos_disponiveis() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long nucleos = sysconf(_SC_NPROCESSORS_ONLN);
+    return (nucleos > 0) ? (int)nucleos : 1;
+#else
+    return 1;
+#endif
+}
+
+// Lê a suíte, opcionalmente ignorando profundidades acima de profundidade_maxima
+static int ler_suite(const char *arquivo, int profundidade_maxima, posicao_suite **posicoes) {
+    FILE *f = fopen(arquivo, "r");
+    if (f == NULL) {
+        return -1;
     }
 
-    printf("\nProfundidade: %d\n", profundidade);
+    int capacidade = 64;
+    int num_posicoes = 0;
+    *posicoes = malloc(sizeof(posicao_suite) * capacidade);
+
+    char linha[1024];
+    while (fgets(linha, sizeof(linha), f)) {
+        linha[strcspn(linha, "\r\n")] = 0;
+
+        char *campos = strchr(linha, ';');
+        if (linha[0] == '#' || campos == NULL) {
+            continue; // comentário ou linha sem contagens
+        }
+        *campos++ = 0;
+
+        // Remove os espaços entre a FEN e o primeiro ';'
+        for (int fim = strlen(linha) - 1; fim >= 0 && linha[fim] == ' '; fim--) {
+            linha[fim] = 0;
+        }
+
+        if (num_posicoes == capacidade) {
+            capacidade *= 2;
+            *posicoes = realloc(*posicoes, sizeof(posicao_suite) * capacidade);
+        }
+
+        posicao_suite *atual = &(*posicoes)[num_posicoes];
+        snprintf(atual->fen, sizeof(atual->fen), "%s", linha);
+        atual->num_profundidades = 0;
+
+        for (char *campo = strtok(campos, ";"); campo; campo = strtok(NULL, ";")) {
+            int profundidade;
+            long esperado;
+
+            if (sscanf(campo, " D%d %ld", &profundidade, &esperado) != 2)
+                continue;
+            if (profundidade_maxima > 0 && profundidade > profundidade_maxima)
+                continue;
+            if (atual->num_profundidades == MAX_PROFUNDIDADES_SUITE)
+                break;
+
+            atual->profundidades[atual->num_profundidades] = profundidade;
+            atual->esperados[atual->num_profundidades] = esperado;
+            atual->num_profundidades++;
+        }
+
+        if (atual->num_profundidades > 0) {
+            num_posicoes++;
+        }
+    }
+
+    fclose(f);
+    return num_posicoes;
+}
+
+static void *executar_suite_thread(void *argumento) {
+    tarefa_suite *tarefa = (tarefa_suite *)argumento;
+
+    int i;
+    while ((i = atomic_fetch_add(&tarefa->proxima, 1)) < tarefa->num_posicoes) {
+        posicao_suite *atual = &tarefa->posicoes[i];
+        posicao_t pos;
+        long obtidos[MAX_PROFUNDIDADES_SUITE];
+        long nos = 0;
+        int ok = 1;
+
+        parseFEN(&pos, atual->fen);
+
+        int inicio = get_tempo_milisegundos();
+        for (int d = 0; d < atual->num_profundidades; d++) {
+            obtidos[d] = perft(&pos, atual->profundidades[d], NULL);
+            nos += obtidos[d];
+            if (obtidos[d] != atual->esperados[d]) {
+                ok = 0;
+            }
+        }
+        int tempo = get_tempo_milisegundos() - inicio;
+
+        atomic_fetch_add(&tarefa->nos_total, nos);
+        if (!ok) {
+            atomic_fetch_add(&tarefa->falhas, 1);
+        }
+
+        pthread_mutex_lock(&tarefa->saida);
+        printf("%4d %s %6d ms  %s\n", i + 1, ok ? "OK    " : "FALHOU", tempo, atual->fen);
+        for (int d = 0; d < atual->num_profundidades; d++) {
+            if (obtidos[d] != atual->esperados[d]) {
+                printf("       D%d esperado %ld, obtido %ld\n", atual->profundidades[d], atual->esperados[d], obtidos[d]);
+            }
+        }
+        fflush(stdout);
+        pthread_mutex_unlock(&tarefa->saida);
+    }
+
+    return NULL;
+}
+
+int perft_suite(const char *arquivo, int profundidade_maxima, int num_threads) {
+    posicao_suite *posicoes = NULL;
+    int num_posicoes = ler_suite(arquivo, profundidade_maxima, &posicoes);
+
+    if (num_posicoes < 0) {
+        printf("Erro ao abrir a suite de perft: %s\n", arquivo);
+        return -1;
+    }
+
+    if (num_threads < 1)
+        num_threads = nucleos_disponiveis();
+    if (num_threads > num_posicoes)
+        num_threads = (num_posicoes > 0) ? num_posicoes : 1;
+
+    tarefa_suite tarefa;
+    tarefa.posicoes = posicoes;
+    tarefa.num_posicoes = num_posicoes;
+    atomic_init(&tarefa.proxima, 0);
+    atomic_init(&tarefa.falhas, 0);
+    atomic_init(&tarefa.nos_total, 0);
+    pthread_mutex_init(&tarefa.saida, NULL);
+
+    printf("Suite %s: %d posicoes, %d threads\n", arquivo, num_posicoes, num_threads);
+    int inicio = get_tempo_milisegundos();
+
+    // A thread chamadora também processa posições
+    pthread_t *threads = malloc(sizeof(pthread_t) * num_threads);
+    for (int t = 1; t < num_threads; t++) {
+        pthread_create(&threads[t], NULL, executar_suite_thread, &tarefa);
+    }
+    executar_suite_thread(&tarefa);
+    for (int t = 1; t < num_threads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+
+    int tempo = get_tempo_milisegundos() - inicio;
+    long nos = atomic_load(&tarefa.nos_total);
+    int falhas = atomic_load(&tarefa.falhas);
+
+    printf("\nPosicoes: %d\n", num_posicoes);
+    printf("Falhas: %d\n", falhas);
     printf("Nos: %ld\n", nos);
-    printf("Tempo: %d ms\n", get_tempo_milisegundos() - inicio);
+    printf("Tempo: %d ms\n", tempo);
+    printf("NPS: %ld\n", tempo > 0 ? nos * 1000 / tempo : 0);
     printf("\n");
+    fflush(stdout);
 
-}   
+    pthread_mutex_destroy(&tarefa.saida);
+    free(posicoes);
+
+    return falhas;
+}
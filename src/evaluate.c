@@ -33,6 +33,8 @@ int material_score[12] = {
 // MÁSCARAS DE AVALIAÇÃO GLOBAL
 // =============================================================================
 
+#ifndef TABELAS_PRECALCULADAS // senão definidas em tabelas_geradas.c
+
 /**
  * @brief Máscaras para colunas do tabuleiro
  */
@@ -58,6 +60,8 @@ u64 peao_passado_branco_masks[64];
  */
 u64 peao_passado_preto_masks[64];
 
+#endif
+
 // =============================================================================
 // PARÂMETROS DE AVALIAÇÃO POSICIONAL
 // =============================================================================
@@ -372,6 +376,7 @@ u64 set_passed_pawn_mask_black(int file, int rank)
 
 void init_evaluation_masks()
 {
+#ifndef TABELAS_PRECALCULADAS
     for (int linha = 0; linha < 8; linha++)
     {
         for (int coluna = 0; coluna < 8; coluna++)
@@ -385,6 +390,7 @@ void init_evaluation_masks()
             peao_passado_preto_masks[casa] = set_passed_pawn_mask_black(coluna, linha);
         }
     }
+#endif
 }
 
 /**
@@ -395,13 +401,13 @@ void init_evaluation_masks()
  *
  * @return Valor total do material (positivo para brancas, negativo para pretas)
  */
-int evaluate_material()
+int evaluate_material(const posicao_t *pos)
 {
     int score = 0;
 
     for (int i = P; i <= k; i++)
     {
-        u64 bitboard = bitboards[i];
+        u64 bitboard = pos->bitboards[i];
         while (bitboard)
         {
             int casa = getLeastBitIndex(bitboard);
@@ -421,13 +427,13 @@ int evaluate_material()
  *
  * @return Valor total da avaliação posicional
  */
-int evaluate_positional()
+int evaluate_positional(const posicao_t *pos)
 {
     int score = 0;
 
     for (int i = P; i <= k; i++)
     {
-        u64 bitboard = bitboards[i];
+        u64 bitboard = pos->bitboards[i];
         while (bitboard)
         {
             int peca = i;
@@ -489,13 +495,13 @@ int evaluate_positional()
  *
  * @return Score da estrutura de peões (positivo favorece brancas)
  */
-int evaluate_pawn_structure()
+int evaluate_pawn_structure(const posicao_t *pos)
 {
     int score = 0;
 
     // Obter bitboards dos peões de ambas as cores
-    u64 peoes_brancos = bitboards[P];
-    u64 peoes_pretos = bitboards[p];
+    u64 peoes_brancos = pos->bitboards[P];
+    u64 peoes_pretos = pos->bitboards[p];
 
     // =========================================================================
     // PARTE 1: ANÁLISE POR COLUNA (Peões dobrados e isolados)
@@ -637,16 +643,16 @@ int evaluate_pawn_structure()
  *
  * @return Score das colunas livres/semi-livres (positivo favorece brancas)
  */
-int evaluate_open_files()
+int evaluate_open_files(const posicao_t *pos)
 {
     int score = 0;
 
     // Obter bitboards dos peões
-    u64 peoes_brancos = bitboards[P];
-    u64 peoes_pretos = bitboards[p];
+    u64 peoes_brancos = pos->bitboards[P];
+    u64 peoes_pretos = pos->bitboards[p];
     
     // AVALIAR TORRES BRANCAS
-    u64 torres_brancas = bitboards[R];
+    u64 torres_brancas = pos->bitboards[R];
     while (torres_brancas)
     {
         int casa = getLeastBitIndex(torres_brancas);
@@ -672,7 +678,7 @@ int evaluate_open_files()
     }
     
     // AVALIAR TORRES PRETAS
-    u64 torres_pretas = bitboards[r];
+    u64 torres_pretas = pos->bitboards[r];
     while (torres_pretas)
     {
         int casa = getLeastBitIndex(torres_pretas);
@@ -698,7 +704,7 @@ int evaluate_open_files()
     }
     
     // AVALIAR DAMAS BRANCAS
-    u64 damas_brancas = bitboards[Q];
+    u64 damas_brancas = pos->bitboards[Q];
     while (damas_brancas)
     {
         int casa = getLeastBitIndex(damas_brancas);
@@ -725,7 +731,7 @@ int evaluate_open_files()
     }
     
     // AVALIAR DAMAS PRETAS
-    u64 damas_pretas = bitboards[q];
+    u64 damas_pretas = pos->bitboards[q];
     while (damas_pretas)
     {
         int casa = getLeastBitIndex(damas_pretas);
@@ -755,7 +761,7 @@ int evaluate_open_files()
     // Reis em colunas livres ou semi-livres são vulneráveis a ataques de torres/damas
     
     // AVALIAR REI BRANCO
-    u64 rei_branco = bitboards[K];
+    u64 rei_branco = pos->bitboards[K];
     if (rei_branco)
     {
         int casa = getLeastBitIndex(rei_branco);
@@ -779,7 +785,7 @@ int evaluate_open_files()
     }
     
     // AVALIAR REI PRETO
-    u64 rei_preto = bitboards[k];
+    u64 rei_preto = pos->bitboards[k];
     if (rei_preto)
     {
         int casa = getLeastBitIndex(rei_preto);
@@ -805,19 +811,19 @@ int evaluate_open_files()
     return score;
 }
 
-int evaluate_king_safety()
+int evaluate_king_safety(const posicao_t *pos)
 {
     int score = 0;
     
     // Obter bitboards dos peões
-    u64 peoes_brancos = bitboards[P];
-    u64 peoes_pretos = bitboards[p];
+    u64 peoes_brancos = pos->bitboards[P];
+    u64 peoes_pretos = pos->bitboards[p];
 
     // =========================================================================
     // SEGURANÇA DO REI BRANCO
     // =========================================================================
     
-    u64 rei_branco = bitboards[K];
+    u64 rei_branco = pos->bitboards[K];
     if (rei_branco)
     {
         int casa_rei = getLeastBitIndex(rei_branco);
@@ -849,7 +855,7 @@ int evaluate_king_safety()
         
         // AVALIAR ATAQUES AO REI E CASAS ADJACENTES
         // Verificar se o rei está sendo atacado
-        if (casaEstaAtacada(casa_rei, preto))
+        if (casaEstaAtacada(pos, casa_rei, preto))
         {
             score -= king_safety_king_attacked_penalty;
         }
@@ -868,7 +874,7 @@ int evaluate_king_safety()
                 if (linha_check >= 0 && linha_check < 8 && col_check >= 0 && col_check < 8)
                 {
                     int casa_check = linha_check * 8 + col_check;
-                    if (casaEstaAtacada(casa_check, preto))
+                    if (casaEstaAtacada(pos, casa_check, preto))
                     {
                         casas_atacadas++;
                     }
@@ -910,7 +916,7 @@ int evaluate_king_safety()
     // SEGURANÇA DO REI PRETO
     // =========================================================================
     
-    u64 rei_preto = bitboards[k];
+    u64 rei_preto = pos->bitboards[k];
     if (rei_preto)
     {
         int casa_rei = getLeastBitIndex(rei_preto);
@@ -941,7 +947,7 @@ int evaluate_king_safety()
         
         // AVALIAR ATAQUES AO REI E CASAS ADJACENTES
         // Verificar se o rei está sendo atacado
-        if (casaEstaAtacada(casa_rei, branco))
+        if (casaEstaAtacada(pos, casa_rei, branco))
         {
             score += king_safety_king_attacked_penalty;
         }
@@ -960,7 +966,7 @@ int evaluate_king_safety()
                 if (linha_check >= 0 && linha_check < 8 && col_check >= 0 && col_check < 8)
                 {
                     int casa_check = linha_check * 8 + col_check;
-                    if (casaEstaAtacada(casa_check, branco))
+                    if (casaEstaAtacada(pos, casa_check, branco))
                     {
                         casas_atacadas++;
                     }
@@ -1001,7 +1007,7 @@ int evaluate_king_safety()
     return score;
 }
 
-int evaluate_mobility()
+int evaluate_mobility(const posicao_t *pos)
 {
     int score = 0;
     u64 ocupacao_total = 0ULL;
@@ -1009,7 +1015,7 @@ int evaluate_mobility()
     // Calcular bitboard de ocupação total (todas as peças)
     for (int peca = P; peca <= k; peca++)
     {
-        ocupacao_total |= bitboards[peca];
+        ocupacao_total |= pos->bitboards[peca];
     }
 
     // =========================================================================
@@ -1017,14 +1023,14 @@ int evaluate_mobility()
     // =========================================================================
     
     // Cavalos brancos
-    u64 cavalos_brancos = bitboards[N];
+    u64 cavalos_brancos = pos->bitboards[N];
     while (cavalos_brancos)
     {
         int casa = getLeastBitIndex(cavalos_brancos);
         u64 ataques = gerarAtaquesCavalo(casa);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_brancas = bitboards[P] | bitboards[N] | bitboards[B] | bitboards[R] | bitboards[Q] | bitboards[K];
+        u64 pecas_brancas = pos->bitboards[P] | pos->bitboards[N] | pos->bitboards[B] | pos->bitboards[R] | pos->bitboards[Q] | pos->bitboards[K];
         ataques &= ~pecas_brancas;
         
         // Contar movimentos disponíveis
@@ -1035,14 +1041,14 @@ int evaluate_mobility()
     }
 
     // Cavalos pretos
-    u64 cavalos_pretos = bitboards[n];
+    u64 cavalos_pretos = pos->bitboards[n];
     while (cavalos_pretos)
     {
         int casa = getLeastBitIndex(cavalos_pretos);
         u64 ataques = gerarAtaquesCavalo(casa);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_pretas = bitboards[p] | bitboards[n] | bitboards[b] | bitboards[r] | bitboards[q] | bitboards[k];
+        u64 pecas_pretas = pos->bitboards[p] | pos->bitboards[n] | pos->bitboards[b] | pos->bitboards[r] | pos->bitboards[q] | pos->bitboards[k];
         ataques &= ~pecas_pretas;
         
         // Contar movimentos disponíveis
@@ -1057,14 +1063,14 @@ int evaluate_mobility()
     // =========================================================================
     
     // Bispos brancos
-    u64 bispos_brancos = bitboards[B];
+    u64 bispos_brancos = pos->bitboards[B];
     while (bispos_brancos)
     {
         int casa = getLeastBitIndex(bispos_brancos);
         u64 ataques = obterAtaquesBispo(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_brancas = bitboards[P] | bitboards[N] | bitboards[B] | bitboards[R] | bitboards[Q] | bitboards[K];
+        u64 pecas_brancas = pos->bitboards[P] | pos->bitboards[N] | pos->bitboards[B] | pos->bitboards[R] | pos->bitboards[Q] | pos->bitboards[K];
         ataques &= ~pecas_brancas;
         
         // Contar movimentos disponíveis
@@ -1075,14 +1081,14 @@ int evaluate_mobility()
     }
 
     // Bispos pretos
-    u64 bispos_pretos = bitboards[b];
+    u64 bispos_pretos = pos->bitboards[b];
     while (bispos_pretos)
     {
         int casa = getLeastBitIndex(bispos_pretos);
         u64 ataques = obterAtaquesBispo(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_pretas = bitboards[p] | bitboards[n] | bitboards[b] | bitboards[r] | bitboards[q] | bitboards[k];
+        u64 pecas_pretas = pos->bitboards[p] | pos->bitboards[n] | pos->bitboards[b] | pos->bitboards[r] | pos->bitboards[q] | pos->bitboards[k];
         ataques &= ~pecas_pretas;
         
         // Contar movimentos disponíveis
@@ -1097,14 +1103,14 @@ int evaluate_mobility()
     // =========================================================================
     
     // Torres brancas
-    u64 torres_brancas = bitboards[R];
+    u64 torres_brancas = pos->bitboards[R];
     while (torres_brancas)
     {
         int casa = getLeastBitIndex(torres_brancas);
         u64 ataques = obterAtaquesTorre(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_brancas = bitboards[P] | bitboards[N] | bitboards[B] | bitboards[R] | bitboards[Q] | bitboards[K];
+        u64 pecas_brancas = pos->bitboards[P] | pos->bitboards[N] | pos->bitboards[B] | pos->bitboards[R] | pos->bitboards[Q] | pos->bitboards[K];
         ataques &= ~pecas_brancas;
         
         // Contar movimentos disponíveis
@@ -1115,14 +1121,14 @@ int evaluate_mobility()
     }
 
     // Torres pretas
-    u64 torres_pretas = bitboards[r];
+    u64 torres_pretas = pos->bitboards[r];
     while (torres_pretas)
     {
         int casa = getLeastBitIndex(torres_pretas);
         u64 ataques = obterAtaquesTorre(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_pretas = bitboards[p] | bitboards[n] | bitboards[b] | bitboards[r] | bitboards[q] | bitboards[k];
+        u64 pecas_pretas = pos->bitboards[p] | pos->bitboards[n] | pos->bitboards[b] | pos->bitboards[r] | pos->bitboards[q] | pos->bitboards[k];
         ataques &= ~pecas_pretas;
         
         // Contar movimentos disponíveis
@@ -1137,14 +1143,14 @@ int evaluate_mobility()
     // =========================================================================
     
     // Damas brancas
-    u64 damas_brancas = bitboards[Q];
+    u64 damas_brancas = pos->bitboards[Q];
     while (damas_brancas)
     {
         int casa = getLeastBitIndex(damas_brancas);
         u64 ataques = obterAtaquesDama(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_brancas = bitboards[P] | bitboards[N] | bitboards[B] | bitboards[R] | bitboards[Q] | bitboards[K];
+        u64 pecas_brancas = pos->bitboards[P] | pos->bitboards[N] | pos->bitboards[B] | pos->bitboards[R] | pos->bitboards[Q] | pos->bitboards[K];
         ataques &= ~pecas_brancas;
         
         // Contar movimentos disponíveis
@@ -1155,14 +1161,14 @@ int evaluate_mobility()
     }
 
     // Damas pretas
-    u64 damas_pretas = bitboards[q];
+    u64 damas_pretas = pos->bitboards[q];
     while (damas_pretas)
     {
         int casa = getLeastBitIndex(damas_pretas);
         u64 ataques = obterAtaquesDama(casa, ocupacao_total);
         
         // Remover casas ocupadas por peças próprias
-        u64 pecas_pretas = bitboards[p] | bitboards[n] | bitboards[b] | bitboards[r] | bitboards[q] | bitboards[k];
+        u64 pecas_pretas = pos->bitboards[p] | pos->bitboards[n] | pos->bitboards[b] | pos->bitboards[r] | pos->bitboards[q] | pos->bitboards[k];
         ataques &= ~pecas_pretas;
         
         // Contar movimentos disponíveis
@@ -1204,37 +1210,37 @@ int evaluate_mobility()
  *
  * @return Valor total da avaliação do ponto de vista do jogador atual
  */
-int evaluate()
+int evaluate(const posicao_t *pos)
 {
     int score = 0;
     int component_score;
 
     // Avaliação material
-    component_score = evaluate_material();
+    component_score = evaluate_material(pos);
     score += component_score;
 
     // Avaliação posicional
-    component_score = evaluate_positional();
+    component_score = evaluate_positional(pos);
     score += component_score;
 
     // Avaliação de estrutura de peões (dobrados, isolados, passados)
-    component_score = evaluate_pawn_structure();
+    component_score = evaluate_pawn_structure(pos);
     score += component_score;
 
     // Avaliação de colunas livres e semi-livres
-    component_score = evaluate_open_files();
+    component_score = evaluate_open_files(pos);
     score += component_score;
 
     // Avaliação de mobilidade das peças
-    component_score = evaluate_mobility();
+    component_score = evaluate_mobility(pos);
     score += component_score;
 
     // Avaliação de segurança do rei
-    component_score = evaluate_king_safety();
+    component_score = evaluate_king_safety(pos);
     score += component_score;
 
     
 
     // Retorna a avaliação do ponto de vista do lado a jogar
-    return (lado_a_jogar == branco) ? score : -score;
+    return (pos->lado_a_jogar == branco) ? score : -score;
 }
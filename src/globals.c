@@ -10,15 +10,7 @@
  */
 
 #include "../include/globals.h"
-
-// =============================================================================
-// VARIÁVEIS DE ESTADO DO JOGO
-// =============================================================================
-
-/**
- * @brief Variável global para backup do estado do jogo
- */
-estado_jogo backup_global;
+#include "../include/ataques.h"
 
 // =============================================================================
 // SISTEMA DE HISTÓRICO E DETECÇÃO DE REPETIÇÃO
@@ -34,20 +26,12 @@ u64 historico_posicoes[MAX_HISTORIA];
  */
 int contador_historia = 0;
 
-/**
- * @brief Histórico de lances para livro de aberturas
- */
-int historico_lances_partida[MAX_LANCES_PARTIDA];
-
-/**
- * @brief Número de lances jogados na partida atual
- */
-int num_lances_partida = 0;
-
 // =============================================================================
 // TABELAS DE ATAQUES PRÉ-CALCULADAS
 // =============================================================================
 
+#ifndef TABELAS_PRECALCULADAS // senão definidas em tabelas_geradas.c
+
 /**
  * @brief Tabela de ataques de peões [lado][casa]
  */
@@ -74,14 +58,31 @@ u64 mask_tabela_ataques_bispo[64];
 u64 mask_tabela_ataques_torre[64];
 
 /**
- * @brief Tabela completa de ataques de bispos [casa][índice_ocupação]
+ * @brief Ataques de bispos e torres compactados pelo número real de bits relevantes de cada casa
+ */
+_Alignas(64) u64 tabela_ataques_deslizantes[TAMANHO_ATAQUES_BISPO + TAMANHO_ATAQUES_TORRE];
+
+/**
+ * @brief Início do trecho de cada casa para bispos
+ */
+u64 *ataques_bispo[64];
+
+/**
+ * @brief Início do trecho de cada casa para torres
  */
-u64 tabela_ataques_bispo[64][512];
+u64 *ataques_torre[64];
 
 /**
- * @brief Tabela completa de ataques de torres [casa][índice_ocupação]
+ * @brief Casas estritamente entre duas casas alinhadas [casa][casa]
  */
-u64 tabela_ataques_torre[64][4096];
+u64 casas_entre[64][64];
+
+/**
+ * @brief Linha completa que passa por duas casas alinhadas [casa][casa]
+ */
+u64 linha_casas[64][64];
+
+#endif
 
 // =============================================================================
 // MAGIC BITBOARDS - DADOS PRÉ-CALCULADOS
@@ -270,51 +271,118 @@ u64 magics_torre[64] = {
 };
 
 // =============================================================================
-// FUNÇÕES DE DETECÇÃO DE REPETIÇÃO
+// CHAVES ZOBRIST
 // =============================================================================
 
 /**
- * @brief Gera um hash simples da posição atual
+ * @brief Chaves Zobrist para cada peça em cada casa [peça][casa]
+ */
+u64 chaves_pecas[12][64];
+
+/**
+ * @brief Chaves Zobrist para a coluna da casa en passant
+ */
+u64 chaves_en_passant[8];
+
+/**
+ * @brief Chaves Zobrist para cada combinação de direitos de roque
+ */
+u64 chaves_roque[16];
+
+/**
+ * @brief Chave Zobrist aplicada quando as pretas jogam
+ */
+u64 chave_lado;
+
+/**
+ * @brief Estado do gerador das chaves Zobrist (semente fixa)
+ */
+static u64 estado_chaves = 0x4D615A6543686573ULL;
+
+/**
+ * @brief Gera uma chave Zobrist de 64 bits (SplitMix64)
  * 
- * Cria um hash da posição baseado nos bitboards das peças, lado a jogar,
- * direitos de roque e en passant. Usado para detecção de repetição.
+ * O xorshift32 dos magic numbers não serve aqui: todas as suas saídas são
+ * funções lineares de um estado de 32 bits, então os XORs das chaves só
+ * ocupariam 2^32 valores e posições diferentes colidiriam com frequência.
+ */
+static u64 gerar_chave_aleatoria() {
+    u64 z = (estado_chaves += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief Inicializa as chaves Zobrist
  * 
- * @return Hash da posição atual
+ * A semente é fixa, então as chaves são idênticas em toda execução e em
+ * qualquer plataforma.
  */
-u64 hash_posicao_simples() {
-    u64 hash = 0;
-    
-    // Hash baseado nos bitboards das peças
-    for (int i = 0; i < 12; i++) {
-        hash ^= bitboards[i];
-        hash = hash * 1103515245ULL + 12345ULL; // Multiplicador LCG simples
+void inicializar_chaves_hash() {
+    for (int peca = P; peca <= k; peca++) {
+        for (int casa = 0; casa < 64; casa++) {
+            chaves_pecas[peca][casa] = gerar_chave_aleatoria();
+        }
     }
-    
-    // Incluir lado a jogar
-    if (lado_a_jogar == preto) {
-        hash ^= 0x123456789ABCDEFULL;
+
+    for (int coluna = 0; coluna < 8; coluna++) {
+        chaves_en_passant[coluna] = gerar_chave_aleatoria();
     }
-    
-    // Incluir direitos de roque
-    hash ^= roque * 0x9E3779B97F4A7C15ULL;
-    
-    // Incluir en passant (se houver)
-    if (en_passant != -1) {  // Assumindo -1 como valor inválido
-        hash ^= en_passant * 0x517CC1B727220A95ULL;
+
+    for (int i = 0; i < 16; i++) {
+        chaves_roque[i] = gerar_chave_aleatoria();
     }
-    
-    return hash;
+
+    chave_lado = gerar_chave_aleatoria();
 }
 
+/**
+ * @brief Calcula do zero a chave Zobrist da posição atual
+ * 
+ * Combina por XOR as chaves de cada peça em sua casa, do lado a jogar,
+ * dos direitos de roque e da coluna en passant (se houver).
+ * 
+ * @return Chave Zobrist da posição atual
+ */
+u64 gerar_chave_hash(const posicao_t *pos) {
+    u64 chave = 0ULL;
+
+    for (int peca = P; peca <= k; peca++) {
+        u64 bitboard = pos->bitboards[peca];
+        while (bitboard) {
+            int casa = getLeastBitIndex(bitboard);
+            chave ^= chaves_pecas[peca][casa];
+            clearBit(bitboard, casa);
+        }
+    }
+
+    if (pos->en_passant != -999) {
+        chave ^= chaves_en_passant[pos->en_passant % 8];
+    }
+
+    chave ^= chaves_roque[pos->roque];
+
+    if (pos->lado_a_jogar == preto) {
+        chave ^= chave_lado;
+    }
+
+    return chave;
+}
+
+// =============================================================================
+// FUNÇÕES DE DETECÇÃO DE REPETIÇÃO
+// =============================================================================
+
 /**
  * @brief Adiciona a posição atual ao histórico de repetição
  * 
  * Calcula o hash da posição atual e adiciona ao histórico para
  * futura detecção de repetição de posições.
  */
-void adicionar_posicao_historia() {
+void adicionar_posicao_historia(const posicao_t *pos) {
     if (contador_historia < MAX_HISTORIA) {
-        historico_posicoes[contador_historia] = hash_posicao_simples();
+        historico_posicoes[contador_historia] = pos->hash_chave;
         contador_historia++;
     }
 }
@@ -328,8 +396,8 @@ void adicionar_posicao_historia() {
  * 
  * @return 1 se posição foi repetida, 0 caso contrário
  */
-int posicao_repetida() {
-    u64 hash_atual = hash_posicao_simples();
+int posicao_repetida(const posicao_t *pos) {
+    u64 hash_atual = pos->hash_chave;
     int contador = 0;
     
     for (int i = 0; i < contador_historia; i++) {
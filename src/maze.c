@@ -19,8 +19,13 @@
 #include "../include/uci.h"
 #include "../include/search.h"
 #include "../include/evaluate.h"
+#include "../include/bench.h"
+#include "../include/transposicao.h"
+#include "../include/tabelas.h"
+#include "../include/aberturas.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 // =============================================================================
 // FUNÇÃO PRINCIPAL
@@ -32,11 +37,58 @@
  * Inicializa todos os sistemas necessários da engine e entra no loop
  * principal do protocolo UCI para comunicação com interfaces gráficas.
  * 
+ * Com "perftsuite <arquivo.epd> [profundidade] [hash]" na linha de comando,
+ * roda a suíte de regressão do perft em todos os núcleos e sai; hash > 0
+ * liga a tabela do perft com esse tamanho em MB.
+ * Com "bench [profundidade] [threads] [hash]", roda o benchmark de busca
+ * e sai (também usado como carga de trabalho do build com PGO).
+ * Com "gerartabelas <arquivo.c>", escreve as tabelas calculadas como dados
+ * const para o build com TABELAS_PRECALCULADAS (make tabelas) e sai.
+ * Com "gerarlivro <aberturas.txt> <aberturas.bin>", compila o livro de
+ * aberturas para o formato binário (make livro) e sai.
+ * Com "conferirlivro", confere que transposições chegam às mesmas entradas
+ * do livro e sai.
+ * 
+ * @param argc Número de argumentos
+ * @param argv Argumentos da linha de comando
  * @return 0 em caso de execução bem-sucedida
  */
-int main()
+int main(int argc, char *argv[])
 {
     runEngine();  // Inicializa sistemas da engine (ataques, avaliação, etc.)
+
+    if (argc >= 3 && strcmp(argv[1], "perftsuite") == 0)
+    {
+        int profundidade_maxima = (argc >= 4) ? atoi(argv[3]) : 0;
+        if (argc >= 5)
+            inicializar_tt_perft(atoi(argv[4]));
+        return (perft_suite(argv[2], profundidade_maxima, 0) == 0) ? 0 : 1;
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "bench") == 0)
+    {
+        executar_bench((argc >= 3) ? atoi(argv[2]) : 0,
+                       (argc >= 4) ? atoi(argv[3]) : 0,
+                       (argc >= 5) ? atoi(argv[4]) : 0);
+        return 0;
+    }
+
+    if (argc >= 3 && strcmp(argv[1], "gerartabelas") == 0)
+    {
+        return exportar_tabelas(argv[2]);
+    }
+
+    if (argc >= 4 && strcmp(argv[1], "gerarlivro") == 0)
+    {
+        return gerar_livro_binario(argv[2], argv[3]);
+    }
+
+    if (argc >= 2 && strcmp(argv[1], "conferirlivro") == 0)
+    {
+        inicializar_livro_aberturas();
+        return (conferir_transposicoes_livro() == 0) ? 0 : 1;
+    }
+
     uci_loop();   // Entra no loop principal UCI
     
     return 0;
@@ -14,47 +14,35 @@
 #include "../include/bitboard.h"
 #include "../include/globals.h"
 #include "../include/ataques.h"
+#include "../include/transposicao.h"
+#include "../include/tempo.h"
+#include "../include/uci.h"
+
+#include <unistd.h>
+#include <pthread.h>
+#include <math.h>
 
 // =============================================================================
 // VARIÁVEIS GLOBAIS DE BUSCA
 // =============================================================================
 
-/**
- * @brief Profundidade atual da busca (ply)
- */
-int ply;
-
-#define MAX_PLY 64
-
-/**
- * @brief Array para detectar repetição na linha de busca atual
- */
-u64 hash_linha_busca[MAX_PLY_BUSCA];
-
-/**
- * @brief Tabela de killer moves [índice][profundidade]
- */
-int killer_moves[2][MAX_PLY];
+#define MAX_PLY MAX_PLY_BUSCA
 
 /**
- * @brief Tabela de history moves [peça][casa]
+ * @brief Redução base do LMR [profundidade][número do lance]
  */
-int history_moves[12][MAX_PLY];
+static int tabela_reducao[MAX_PLY_BUSCA][MAX_LANCES_REDUCAO];
 
 /**
- * @brief Comprimento da variação principal em cada profundidade
+ * @brief Dados de uma thread auxiliar do Lazy SMP
  */
-int pv_length[MAX_PLY];
-
-/**
- * @brief Tabela triangular da variação principal
- */
-int pv_table[MAX_PLY][MAX_PLY];
-
-/**
- * @brief Flags para controle da variação principal
- */
-int follow_pv, score_pv;
+typedef struct {
+    pthread_t thread;       ///< Identificador da thread
+    int id;                 ///< Índice da thread (1..num_threads-1)
+    int profundidade;       ///< Profundidade máxima da busca
+    motor_t *motor;         ///< Contexto de busca da thread
+    atomic_long *nos_auxiliares; ///< Nós das auxiliares, somados por busca_lance()
+} thread_auxiliar;
 
 // =============================================================================
 // FUNÇÕES DE DETECÇÃO DE REPETIÇÃO
@@ -68,12 +56,12 @@ int follow_pv, score_pv;
  * 
  * @return 1 se repetição detectada, 0 caso contrário
  */
-int detectar_repeticao_busca() {
-    u64 hash_atual = hash_posicao_simples();
+int detectar_repeticao_busca(motor_t *motor) {
+    u64 hash_atual = motor->pos.hash_chave;
     
     // Verificar se esta posição já apareceu na linha de busca atual
-    for (int i = 0; i < ply; i++) {
-        if (hash_linha_busca[i] == hash_atual) {
+    for (int i = 0; i < motor->ply; i++) {
+        if (motor->hash_linha_busca[i] == hash_atual) {
             return 1; // Repetição detectada
         }
     }
@@ -85,23 +73,17 @@ int detectar_repeticao_busca() {
 // =============================================================================
 
 /**
- * @brief Habilita pontuação para seguir a variação principal
- * 
- * Verifica se algum lance na lista corresponde ao lance da PV
- * na profundidade atual e configura flags apropriadas.
+ * @brief Lance da variação principal a ser buscado primeiro neste ply
  * 
- * @param listaLances Lista de lances a verificar
+ * Verifica se o lance da PV na profundidade atual é válido na posição
+ * e desliga follow_pv quando a linha principal acabou.
  */
-void enable_pv_scoring(lances *listaLances) {
-    follow_pv = 0;
+int enable_pv_scoring(motor_t *motor) {
+    int lance_pv = motor->pv_table[0][motor->ply];
 
-    for(int i = 0; i < listaLances->contador; i++) {
-        if(pv_table[0][ply] == listaLances->lances[i]) {
-            follow_pv = 1;
-            score_pv = 1;
-            break;
-        }
-    }
+    motor->follow_pv = lance_valido(&motor->pos, lance_pv);
+
+    return motor->follow_pv ? lance_pv : 0;
 }
 
 /*
@@ -236,165 +218,401 @@ int get_mvv_lva_score(int atacante, int vitima)
     return mvv_lva[atacante][vitima];
 }
 
-int quiescence(int alpha, int beta)
+/**
+ * @brief Indica se uma captura perde material segundo a SEE
+ *
+ * Capturar uma peça de valor igual ou maior nunca perde material, então a SEE
+ * só é calculada quando o atacante vale mais que a vítima.
+ *
+ * @param pos Posição atual
+ * @param lance Captura do lado a jogar
+ * @return 1 se a troca é perdedora, 0 caso contrário
+ */
+static int captura_perdedora(const posicao_t *pos, int lance)
 {
+    int atacante = get_peca(lance);
 
-    
-    int evaluation = evaluate();
+    if (atacante == P || atacante == p || get_en_passant(lance))
+    {
+        return 0;
+    }
+
+    int vitima = pos->peca_na_casa[get_destino(lance)]; // SEM_PECA no en passant
+
+    if (vitima != SEM_PECA && material_score[vitima % 6] >= material_score[atacante % 6])
+    {
+        return 0;
+    }
+
+    return see(pos, lance) < 0;
+}
+
+int quiescence(motor_t *motor, int alpha, int beta)
+{
+    posicao_t *pos = &motor->pos;
+
+    motor->nos++;
+
+    // Consultar o relógio periodicamente
+    if ((motor->nos & (INTERVALO_VERIFICACAO_TEMPO - 1)) == 0)
+    {
+        verificar_tempo(motor->controle);
+    }
+
+    if (motor->controle->parar)
+    {
+        return 0;
+    }
+
+    if (motor->ply > MAX_PLY - 1)
+    {
+        return evaluate(pos);
+    }
+
+    u64 chave = pos->hash_chave;
+
+    // Consultar tabela de transposição (entradas de qualquer profundidade servem)
+    int lance_hash = 0;
+    int score_hash = sondar_tt(chave, 0, alpha, beta, motor->ply, &lance_hash);
+
+    if (motor->ply && score_hash != SEM_ENTRADA_HASH)
+    {
+        return score_hash;
+    }
+
+    int evaluation = evaluate(pos);
 
     if (evaluation >= beta)
     {
         return beta;
     }
 
+    int alpha_original = alpha;
+    int melhor_lance = 0;
+
     if (evaluation > alpha)
     {
         alpha = evaluation;
     }
 
-    lances listaLances[1];
-    gerar_lances(listaLances);
-
-    sort_moves(listaLances);
+    // Capturas que perdem material não mudam o resultado do stand pat:
+    // o seletor nem chega a devolvê-las
+    seletor_lances seletor;
+    iniciar_seletor(&seletor, motor, lance_hash, 1);
 
-    for (int i = 0; i < listaLances->contador; i++)
+    int lance;
+    while ((lance = proximo_lance(&seletor, motor)))
     {
-        estado_jogo backup_local; // Backup local para cada lance
-        SALVAR_ESTADO(backup_local);
-        ply++;
+        registro_desfazer desfazer;
+        motor->ply++;
 
-        if (fazer_lance(listaLances->lances[i], lancesCaptura, backup_local) == 0)
+        if (fazer_lance(pos, lance, todosLances, &desfazer) == 0)
         {
-            ply--;
+            motor->ply--;
             continue;
         }
 
-        int score = -quiescence(-beta, -alpha);
+        int score = -quiescence(motor, -beta, -alpha);
+
+        desfazer_lance(pos, lance, &desfazer);
+        motor->ply--;
 
-        RESTAURAR_ESTADO(backup_local); // Restaurar do backup local
-        ply--;
+        // Busca interrompida: o score não é confiável e não deve ir para a tabela
+        if (motor->controle->parar)
+        {
+            return 0;
+        }
 
         if (score >= beta)
         {
+            gravar_tt(chave, 0, beta, hash_beta, lance, motor->ply);
             return beta; // Poda beta
         }
 
         if (score > alpha)
         {
             alpha = score;
+            melhor_lance = lance;
         }
     }
+
+    gravar_tt(chave, 0, alpha, (alpha > alpha_original) ? hash_exato : hash_alfa, melhor_lance, motor->ply);
+
     return alpha;
 }
 
-// variante minimax
-int negamax(int alpha, int beta, int depth)
+/**
+ * @brief Verifica se o lado a jogar tem alguma peça além de rei e peões
+ */
+static int tem_pecas_alem_de_peoes(const posicao_t *pos)
 {
+    int base = (pos->lado_a_jogar == branco) ? N : n;
 
-    int found_pv;
+    return (pos->bitboards[base] | pos->bitboards[base + 1] | pos->bitboards[base + 2] | pos->bitboards[base + 3]) != 0ULL;
+}
+
+/**
+ * @brief Soma um bônus de profundidade ao histórico de um lance quieto
+ *
+ * Quando um valor passaria de MAX_HISTORICO a tabela inteira é dividida
+ * por dois, mantendo a ordem relativa e dando mais peso ao que é recente.
+ */
+static void atualizar_historico(motor_t *motor, int lance, int depth)
+{
+    int *historico = &motor->history_moves[get_peca(lance)][get_destino(lance)];
+
+    *historico += depth * depth;
+
+    if (*historico > MAX_HISTORICO)
+    {
+        for (int peca = 0; peca < 12; peca++)
+        {
+            for (int casa = 0; casa < 64; casa++)
+            {
+                motor->history_moves[peca][casa] /= 2;
+            }
+        }
+    }
+}
+
+void inicializar_reducoes()
+{
+    for (int profundidade = 0; profundidade < MAX_PLY_BUSCA; profundidade++)
+    {
+        for (int lance = 0; lance < MAX_LANCES_REDUCAO; lance++)
+        {
+            if (profundidade == 0 || lance == 0)
+            {
+                tabela_reducao[profundidade][lance] = 0;
+                continue;
+            }
+
+            tabela_reducao[profundidade][lance] = (int)(0.75 + log(profundidade) * log(lance) / 2.25);
+        }
+    }
+}
+
+// variante minimax
+int negamax(motor_t *motor, int alpha, int beta, int depth)
+{
+    posicao_t *pos = &motor->pos;
 
     int score;
 
-    pv_length[ply] = ply;
+    int hash_flag = hash_alfa;
+
+    int melhor_lance = 0;
+
+    int pv_node = (beta - alpha) > 1;
+
+    motor->pv_length[motor->ply] = motor->ply;
 
     if (depth == 0)
     {
-        return quiescence(alpha, beta);
+        return quiescence(motor, alpha, beta);
     }
 
-    if (ply > MAX_PLY - 1)
+    // Limite das tabelas indexadas por ply (o filho ainda acessa pv_length[ply + 1])
+    if (motor->ply >= MAX_PLY - 1)
     {
-        return evaluate();
+        return evaluate(pos);
     }
 
     // Detectar repetição na linha de busca
-    if (detectar_repeticao_busca()) {
+    if (detectar_repeticao_busca(motor)) {
         return 0; // Empate por repetição
     }
 
     // Armazenar hash da posição atual na linha de busca
-    hash_linha_busca[ply] = hash_posicao_simples();
+    u64 chave = pos->hash_chave;
 
-    nos++;
+    motor->hash_linha_busca[motor->ply] = chave;
 
-    int em_cheque = casaEstaAtacada((lado_a_jogar == branco) ? getLeastBitIndex(bitboards[K]) : getLeastBitIndex(bitboards[k]), lado_a_jogar ^ 1);
+    // Consultar tabela de transposição: corte em nós fora da PV, lance para ordenação em todos
+    int lance_hash = 0;
+    score = sondar_tt(chave, depth, alpha, beta, motor->ply, &lance_hash);
+
+    if (motor->ply && !pv_node && score != SEM_ENTRADA_HASH)
+    {
+        return score;
+    }
+
+    motor->nos++;
+
+    // Consultar o relógio periodicamente
+    if ((motor->nos & (INTERVALO_VERIFICACAO_TEMPO - 1)) == 0)
+    {
+        verificar_tempo(motor->controle);
+    }
+
+    if (motor->controle->parar)
+    {
+        return 0;
+    }
+
+    int em_cheque = casaEstaAtacada(pos, (pos->lado_a_jogar == branco) ? getLeastBitIndex(pos->bitboards[K]) : getLeastBitIndex(pos->bitboards[k]), pos->lado_a_jogar ^ 1);
 
     if (em_cheque)
     {
         depth++; // Extensão de profundidade se em cheque
     }
 
-    int lances_legais = 0;
+    // Poda do lance nulo: se mesmo passando a vez o oponente não alcança beta,
+    // o nó quase certamente falha alto. Não vale em xeque, na PV, logo após
+    // outro lance nulo, dentro de uma verificação, nem só com rei e peões
+    // (zugzwang é comum nesses finais).
+    if (!pv_node && !em_cheque && motor->ply && depth >= PROFUNDIDADE_MINIMA_NULO &&
+        !motor->lance_nulo[motor->ply - 1] && !motor->verificando_nulo &&
+        tem_pecas_alem_de_peoes(pos) && evaluate(pos) >= beta)
+    {
+        int reducao = REDUCAO_NULO + (depth >= PROFUNDIDADE_REDUCAO_NULO_EXTRA);
+        registro_desfazer desfazer_nulo;
 
+        fazer_lance_nulo(pos, &desfazer_nulo);
+        motor->lance_nulo[motor->ply] = 1;
+        motor->ply++;
 
+        score = -negamax(motor, -beta, -beta + 1, depth - 1 - reducao);
 
-    lances listaLances[1];
-    gerar_lances(listaLances);
+        motor->ply--;
+        motor->lance_nulo[motor->ply] = 0;
+        desfazer_lance_nulo(pos, &desfazer_nulo);
 
-    if(follow_pv){
-        enable_pv_scoring(listaLances);
+        if (motor->controle->parar)
+        {
+            return 0;
+        }
+
+        if (score >= beta)
+        {
+            // Em profundidade alta, confirma o corte com uma busca reduzida sem lance nulo
+            if (depth >= PROFUNDIDADE_VERIFICACAO_NULO)
+            {
+                motor->verificando_nulo = 1;
+                score = negamax(motor, beta - 1, beta, depth - reducao);
+                motor->verificando_nulo = 0;
+
+                if (motor->controle->parar)
+                {
+                    return 0;
+                }
+            }
+
+            if (score >= beta)
+            {
+                return beta;
+            }
+        }
     }
 
-    sort_moves(listaLances);
+    int lances_legais = 0;
 
-    for (int i = 0; i < listaLances->contador; i++)
+    seletor_lances seletor;
+    iniciar_seletor(&seletor, motor, lance_hash, 0);
+
+    int lance;
+    while ((lance = proximo_lance(&seletor, motor)))
     {
-        estado_jogo backup_local; // Backup local para cada lance
-        SALVAR_ESTADO(backup_local);
-        ply++;
+        registro_desfazer desfazer;
+        motor->ply++;
 
-        if (fazer_lance(listaLances->lances[i], todosLances, backup_local) == 0)
+        if (fazer_lance(pos, lance, todosLances, &desfazer) == 0)
         {
-            ply--;
+            motor->ply--;
             continue;
         }
 
         lances_legais++;
 
-        if(found_pv){
-            score = -negamax(-alpha - 1, -alpha, depth - 1);
+        if (lances_legais == 1)
+        {
+            score = -negamax(motor, -beta, -alpha, depth - 1); // Primeiro lance: janela completa
+        }
+        else
+        {
+            int reducao = 0;
+
+            // LMR: lances quietos tardios, que quase nunca superam alpha, são
+            // buscados com profundidade menor
+            if (depth >= PROFUNDIDADE_MINIMA_LMR && lances_legais > LANCES_SEM_REDUCAO && !em_cheque &&
+                !get_captura(lance) && !get_peca_promovida(lance) &&
+                lance != motor->killer_moves[0][motor->ply - 1] && lance != motor->killer_moves[1][motor->ply - 1] &&
+                !casaEstaAtacada(pos, getLeastBitIndex(pos->bitboards[(pos->lado_a_jogar == branco) ? K : k]), pos->lado_a_jogar ^ 1))
+            {
+                reducao = tabela_reducao[depth < MAX_PLY_BUSCA ? depth : MAX_PLY_BUSCA - 1]
+                                        [lances_legais < MAX_LANCES_REDUCAO ? lances_legais : MAX_LANCES_REDUCAO - 1];
+
+                // Menos redução na PV e para lances com bom histórico
+                reducao -= pv_node;
+                reducao -= motor->history_moves[get_peca(lance)][get_destino(lance)] / (MAX_HISTORICO / 2);
 
-            if((score > alpha) && (score < beta)){
-                score = -negamax(-beta, -alpha, depth - 1); // Re-search
+                if (reducao > depth - 2)
+                    reducao = depth - 2;
+                if (reducao < 0)
+                    reducao = 0;
+            }
+
+            // PVS: janela nula, reduzida se for o caso
+            score = -negamax(motor, -alpha - 1, -alpha, depth - 1 - reducao);
+
+            // Falhou alto com redução: repete na profundidade normal
+            if (reducao && score > alpha)
+            {
+                score = -negamax(motor, -alpha - 1, -alpha, depth - 1);
+            }
+
+            if ((score > alpha) && (score < beta))
+            {
+                score = -negamax(motor, -beta, -alpha, depth - 1); // Re-search
             }
-        } else {
-            score = -negamax(-beta, -alpha, depth - 1);
         }
 
-        RESTAURAR_ESTADO(backup_local); // Restaurar do backup local
-        ply--;
+        desfazer_lance(pos, lance, &desfazer);
+        motor->ply--;
+
+        // Busca interrompida: o score não é confiável e não deve ir para a tabela
+        if (motor->controle->parar)
+        {
+            return 0;
+        }
 
         if (score >= beta)
         {
-            if (get_captura(listaLances->lances[i]))
+            if (!get_captura(lance))
             {
-                // Atualizar killer moves
-                killer_moves[1][ply] = killer_moves[0][ply];
-                killer_moves[0][ply] = listaLances->lances[i];
+                // Atualizar killer moves (apenas lances quietos)
+                motor->killer_moves[1][motor->ply] = motor->killer_moves[0][motor->ply];
+                motor->killer_moves[0][motor->ply] = lance;
+
+                atualizar_historico(motor, lance, depth);
             }
 
+            gravar_tt(chave, depth, beta, hash_beta, lance, motor->ply);
+
             return beta; // Poda beta
         }
 
         if (score > alpha)
         {
-            if (get_captura(listaLances->lances[i]))
+            if (!get_captura(lance))
             {
-                history_moves[get_peca(listaLances->lances[i])][get_destino(listaLances->lances[i])] += 1;
+                atualizar_historico(motor, lance, depth);
             }
 
             alpha = score;
 
-            found_pv = 1;
+            hash_flag = hash_exato;
+
+            melhor_lance = lance;
 
             // Atualizar a tabela PV
-            pv_table[ply][ply] = listaLances->lances[i];
+            motor->pv_table[motor->ply][motor->ply] = lance;
 
-            for (int next_ply = ply + 1; next_ply < pv_length[ply + 1]; next_ply++)
+            for (int next_ply = motor->ply + 1; next_ply < motor->pv_length[motor->ply + 1]; next_ply++)
             {
-                pv_table[ply][next_ply] = pv_table[ply + 1][next_ply];
+                motor->pv_table[motor->ply][next_ply] = motor->pv_table[motor->ply + 1][next_ply];
             }
-            pv_length[ply] = pv_length[ply + 1];
+            motor->pv_length[motor->ply] = motor->pv_length[motor->ply + 1];
         }
     }
 
@@ -402,7 +620,7 @@ int negamax(int alpha, int beta, int depth)
     {
         if (em_cheque)
         {
-            return -99999 + ply; // cheque mate
+            return -VALOR_MATE + motor->ply; // cheque mate
         }
         else
         {
@@ -410,213 +628,453 @@ int negamax(int alpha, int beta, int depth)
         }
     }
 
+    gravar_tt(chave, depth, alpha, hash_flag, melhor_lance, motor->ply);
+
     return alpha;
 }
 
-void busca_lance(int depth)
+/**
+ * @brief Primeiro lance legal da posição (0 se não houver)
+ *
+ * Usado quando a busca é interrompida antes de qualquer iteração terminar.
+ */
+static int primeiro_lance_legal(posicao_t *pos)
 {
-    int score;
-    nos = 0;
-    follow_pv = 0;
-    score_pv = 0;
-
-    memset(killer_moves, 0, sizeof(killer_moves));
-    memset(history_moves, 0, sizeof(history_moves));
-    memset(pv_length, 0, sizeof(pv_length));
-    memset(pv_table, 0, sizeof(pv_table));
-    memset(hash_linha_busca, 0, sizeof(hash_linha_busca));
+    lances listaLances[1];
+    gerar_lances(pos, listaLances);
 
-    // Para detectar mate em 1, precisa de pelo menos profundidade 2
-    if (depth < 2)
+    for (int i = 0; i < listaLances->contador; i++)
     {
-        depth = 2;
+        registro_desfazer desfazer;
+
+        if (fazer_lance(pos, listaLances->lances[i], todosLances, &desfazer))
+        {
+            desfazer_lance(pos, listaLances->lances[i], &desfazer);
+            return listaLances->lances[i];
+        }
     }
 
-    // Iterative deepening
-    for (int i = 1; i <= depth; i++)
+    return 0;
+}
+
+/**
+ * @brief Zera as tabelas de busca de um contexto
+ */
+static void limpar_dados_busca(motor_t *motor)
+{
+    motor->nos = 0;
+    motor->ply = 0;
+    motor->follow_pv = 0;
+
+    memset(motor->killer_moves, 0, sizeof(motor->killer_moves));
+    memset(motor->history_moves, 0, sizeof(motor->history_moves));
+    memset(motor->pv_length, 0, sizeof(motor->pv_length));
+    memset(motor->pv_table, 0, sizeof(motor->pv_table));
+    memset(motor->hash_linha_busca, 0, sizeof(motor->hash_linha_busca));
+    memset(motor->lance_nulo, 0, sizeof(motor->lance_nulo));
+    motor->verificando_nulo = 0;
+}
+
+/**
+ * @brief Busca a raiz com janela de aspiração em torno do score anterior
+ *
+ * Em profundidades rasas ou com score de mate a janela é completa. Se o
+ * resultado cair fora da janela, apenas o lado que falhou é alargado (o
+ * dobro a cada nova falha) e a raiz é buscada de novo.
+ */
+static int buscar_raiz(motor_t *motor, int profundidade, int score_anterior)
+{
+    int alpha = -VALOR_MATE;
+    int beta = VALOR_MATE;
+    int delta = JANELA_ASPIRACAO;
+
+    if (profundidade >= PROFUNDIDADE_MINIMA_ASPIRACAO && score_anterior > -LIMITE_MATE && score_anterior < LIMITE_MATE)
     {
+        alpha = score_anterior - delta;
+        beta = score_anterior + delta;
+    }
 
-        follow_pv = 1;
-        score = negamax(-99999, 99999, i);
+    while (1)
+    {
+        motor->follow_pv = 1;
+        int score = negamax(motor, alpha, beta, profundidade);
 
-        printf("info score cp %d depth %d nodes %ld pv ", score, i, nos);
+        if (motor->controle->parar)
+        {
+            return score;
+        }
 
-        for (int j = 0; j < pv_length[0]; j++)
+        if (score <= alpha && alpha > -VALOR_MATE)
         {
-            printLance(pv_table[0][j]);
-            printf(" ");
+            alpha = (score - delta > -VALOR_MATE) ? score - delta : -VALOR_MATE;
+        }
+        else if (score >= beta && beta < VALOR_MATE)
+        {
+            beta = (score + delta < VALOR_MATE) ? score + delta : VALOR_MATE;
+        }
+        else
+        {
+            return score;
         }
 
-        printf("\n");
+        delta *= 2;
     }
+}
+
+/**
+ * @brief Laço de aprofundamento iterativo de uma thread auxiliar (Lazy SMP)
+ *
+ * Busca a mesma posição da thread principal sem imprimir nada; o ganho vem
+ * das entradas que grava na tabela de transposição compartilhada. Metade das
+ * auxiliares começa uma profundidade à frente para diversificar as árvores.
+ */
+static void *busca_auxiliar(void *argumento)
+{
+    thread_auxiliar *auxiliar = (thread_auxiliar *)argumento;
+    motor_t *motor = auxiliar->motor;
+
+    long nos_contados = 0;
+    int score = 0;
 
-    printf("\n");
+    for (int i = 1 + (auxiliar->id & 1); i <= auxiliar->profundidade && !motor->controle->parar; i++)
+    {
+        score = buscar_raiz(motor, i, score);
+
+        atomic_fetch_add(auxiliar->nos_auxiliares, motor->nos - nos_contados);
+        nos_contados = motor->nos;
+    }
 
-    printf("bestmove ");
-    printLance(pv_table[0][0]); // é o melhor lance da linha principal
-    printf("\n");
+    return NULL;
 }
 
-int score_move(int move)
+long busca_lance(motor_t motores[], int num_threads, controle_tempo_t *controle, const posicao_t *pos, int depth)
 {
-    int capturada = get_captura(move);
-    int promocao = get_peca_promovida(move);
-    int destino = get_destino(move);
-    int atacante = get_peca(move);
+    int score = 0;
+    int melhor_lance = 0;
 
-    int base_score = 0;
+    motor_t *motor = &motores[0];
+    motor->pos = *pos;
+    motor->controle = controle;
+    limpar_dados_busca(motor);
 
-    if(score_pv){
-        if(pv_table[0][ply] == move){
+    nova_busca_tt();
 
-            score_pv = 0;
-            return 10000; // Melhor lance da linha principal
-        }
+    // Para detectar mate em 1, precisa de pelo menos profundidade 2
+    if (depth < 2)
+    {
+        depth = 2;
     }
 
-    // Primeiro, calcular score da captura (se houver)
-    if (capturada)
+    // Lazy SMP: threads auxiliares buscam a mesma posição em paralelo
+    thread_auxiliar auxiliares[MAX_THREADS_BUSCA];
+    int num_auxiliares = 0;
+    atomic_long nos_auxiliares;
+    atomic_init(&nos_auxiliares, 0);
+
+    if (num_threads > 1)
     {
-        // É uma captura, vamos encontrar qual peça foi capturada
-        int pecaCapturada = 12; // Valor inválido por padrão
+        pthread_attr_t atributos;
+        pthread_attr_init(&atributos);
+        pthread_attr_setstacksize(&atributos, TAMANHO_PILHA_BUSCA);
 
-        // Determinar qual peça está sendo capturada no destino
-        int pecaInicial, pecaFinal;
-        if (lado_a_jogar == branco)
+        for (int t = 1; t < num_threads && t < MAX_THREADS_BUSCA; t++)
         {
-            // Brancas jogam, capturam peças pretas
-            pecaInicial = p;
-            pecaFinal = k;
-        }
-        else
-        {
-            // Pretas jogam, capturam peças brancas
-            pecaInicial = P;
-            pecaFinal = K;
-        }
+            thread_auxiliar *auxiliar = &auxiliares[num_auxiliares];
 
-        // Encontrar qual peça está no destino
-        for (int peca = pecaInicial; peca <= pecaFinal; peca++)
-        {
-            if (getBit(bitboards[peca], destino))
+            auxiliar->id = t;
+            auxiliar->profundidade = depth;
+            auxiliar->motor = &motores[t];
+            auxiliar->nos_auxiliares = &nos_auxiliares;
+            auxiliar->motor->pos = *pos;
+            auxiliar->motor->controle = controle;
+            limpar_dados_busca(auxiliar->motor);
+
+            if (pthread_create(&auxiliar->thread, &atributos, busca_auxiliar, auxiliar) != 0)
             {
-                pecaCapturada = peca;
-                break;
+                break; // Segue com as threads que conseguiu criar
             }
+
+            num_auxiliares++;
         }
 
-        return get_mvv_lva_score(atacante, pecaCapturada);
+        pthread_attr_destroy(&atributos);
     }
-    else
+
+    // Iterative deepening
+    for (int i = 1; i <= depth; i++)
     {
-        // killer moves e history moves
+        int inicio_iteracao = tempo_decorrido(controle);
 
-        if (killer_moves[0][ply] == move)
+        score = buscar_raiz(motor, i, score);
+
+        // Iteração interrompida pelo relógio: fica com o resultado da anterior
+        if (motor->controle->parar)
         {
-            return 90; // Entre as piores capturas (1-9) e melhores capturas (21-1000)
+            break;
         }
-        else if (killer_moves[1][ply] == move)
+
+        melhor_lance = motor->pv_table[0][0];
+
+        // A partir daqui já existe um lance para devolver se o tempo acabar
+        controle->pode_parar = 1;
+
+        printf("info score cp %d depth %d nodes %ld time %d pv ", score, i, motor->nos + atomic_load(&nos_auxiliares), tempo_decorrido(controle));
+
+        for (int j = 0; j < motor->pv_length[0]; j++)
         {
-            return 80; // Segundo killer move com score menor
+            printLance(motor->pv_table[0][j]);
+            printf(" ");
         }
-        else
+
+        printf("\n");
+
+        if (!iniciar_proxima_iteracao(controle, tempo_decorrido(controle) - inicio_iteracao))
         {
-            return history_moves[atacante][destino];
+            break;
         }
     }
 
-    return 0;
+    // Em "go infinite" e "go ponder" o bestmove só pode sair depois de "stop"/"ponderhit"
+    while (aguardando_stop(controle) && !controle->parar)
+    {
+        usleep(1000);
+    }
+
+    // Encerrar as threads auxiliares
+    controle->parar = 1;
+
+    for (int t = 0; t < num_auxiliares; t++)
+    {
+        pthread_join(auxiliares[t].thread, NULL);
+    }
+
+    // Interrompida antes de completar a primeira iteração: usa o melhor lance parcial
+    if (melhor_lance == 0)
+    {
+        melhor_lance = motor->pv_table[0][0] ? motor->pv_table[0][0] : primeiro_lance_legal(&motor->pos);
+    }
+
+    char lance_str[8] = "0000"; // Notação UCI para "sem lance" (mate ou afogamento)
+
+    if (melhor_lance)
+    {
+        lance_para_uci(melhor_lance, lance_str); // melhor lance da última iteração completa
+    }
+
+    // Uma única escrita, para não intercalar com respostas da thread UCI
+    printf("\nbestmove %s\n", lance_str);
+
+    return motor->nos + atomic_load(&nos_auxiliares);
 }
 
-void print_move_scores()
-{
-    lances listaLances[1];
-    gerar_lances(listaLances);
+// =============================================================================
+// SELETOR DE LANCES
+// =============================================================================
 
-    if (listaLances->contador == 0)
+/**
+ * @brief Devolve o melhor lance restante da lista (seleção) e avança o índice
+ */
+static int selecionar_melhor(seletor_lances *seletor)
+{
+    if (seletor->indice >= seletor->lista.contador)
     {
-        return;
+        return 0;
     }
 
-    for (int i = 0; i < listaLances->contador; i++)
+    int melhor = seletor->indice;
+    for (int i = seletor->indice + 1; i < seletor->lista.contador; i++)
     {
-        int move = listaLances->lances[i];
-        int score = score_move(move);
-        printLance(move);
-        printf(" Score: %d\n", score);
+        if (seletor->scores[i] > seletor->scores[melhor])
+        {
+            melhor = i;
+        }
     }
+
+    int lance = seletor->lista.lances[melhor];
+    seletor->lista.lances[melhor] = seletor->lista.lances[seletor->indice];
+    seletor->scores[melhor] = seletor->scores[seletor->indice];
+    seletor->indice++;
+
+    return lance;
 }
 
 /**
- * @brief Função auxiliar para trocar dois elementos nos arrays de lances e scores
+ * @brief Indica se o lance já foi devolvido no estágio do hash
  */
-void swap_moves(lances *listaLances, int *move_scores, int i, int j)
+static int lance_prioritario(const seletor_lances *seletor, int lance)
 {
-    // Trocar lances
-    int temp_move = listaLances->lances[i];
-    listaLances->lances[i] = listaLances->lances[j];
-    listaLances->lances[j] = temp_move;
-
-    // Trocar scores
-    int temp_score = move_scores[i];
-    move_scores[i] = move_scores[j];
-    move_scores[j] = temp_score;
+    return lance == seletor->prioritarios[0] || lance == seletor->prioritarios[1];
 }
 
 /**
- * @brief Particiona o array para quicksort (ordena do maior para o menor score)
+ * @brief Pontua um lance quieto: histórico, com promoções fora da faixa dele
+ *
+ * O histórico vai de 0 a MAX_HISTORICO; a promoção a dama vem antes de
+ * todos os quietos e as subpromoções depois de todos.
  */
-int partition(lances *listaLances, int *move_scores, int low, int high)
+static int pontuar_quieto(const motor_t *motor, int lance)
 {
-    int pivot = move_scores[high]; // Usa o último elemento como pivot
-    int i = low - 1;               // Índice do menor elemento
+    int promovida = get_peca_promovida(lance);
 
-    for (int j = low; j < high; j++)
+    if (promovida)
     {
-        // Se o elemento atual é MAIOR que o pivot (queremos ordem decrescente)
-        if (move_scores[j] > pivot)
-        {
-            i++;
-            swap_moves(listaLances, move_scores, i, j);
-        }
+        return (promovida == Q || promovida == q) ? MAX_HISTORICO + 1 : -1;
     }
 
-    swap_moves(listaLances, move_scores, i + 1, high);
-    return i + 1;
+    return motor->history_moves[get_peca(lance)][get_destino(lance)];
 }
 
-/**
- * @brief Implementação recursiva do quicksort para ordenar lances por score
- */
-void quicksort_moves(lances *listaLances, int *move_scores, int low, int high)
+void iniciar_seletor(seletor_lances *seletor, motor_t *motor, int lance_hash, int somente_capturas)
 {
-    if (low < high)
+    const posicao_t *pos = &motor->pos;
+
+    seletor->estagio = ESTAGIO_HASH;
+    seletor->somente_capturas = somente_capturas;
+    seletor->indice = 0;
+    seletor->num_ruins = 0;
+    seletor->prioritarios[0] = 0;
+    seletor->prioritarios[1] = 0;
+    seletor->killers[0] = 0;
+    seletor->killers[1] = 0;
+
+    // O lance da tabela pode ser de outra posição (colisão) e precisa ser conferido
+    if (lance_valido(pos, lance_hash))
     {
-        int pi = partition(listaLances, move_scores, low, high);
+        if (!somente_capturas ||
+            (get_captura(lance_hash) && (get_peca_promovida(lance_hash) || !captura_perdedora(pos, lance_hash))))
+        {
+            seletor->prioritarios[0] = lance_hash;
+        }
+    }
 
-        // Recursivamente ordenar elementos antes e depois da partição
-        quicksort_moves(listaLances, move_scores, low, pi - 1);
-        quicksort_moves(listaLances, move_scores, pi + 1, high);
+    if (!somente_capturas && motor->follow_pv)
+    {
+        int lance_pv = enable_pv_scoring(motor);
+
+        if (lance_pv != seletor->prioritarios[0])
+        {
+            seletor->prioritarios[1] = lance_pv;
+        }
     }
 }
 
-int sort_moves(lances *listaLances)
+int proximo_lance(seletor_lances *seletor, motor_t *motor)
 {
-    if (listaLances->contador <= 1)
+    const posicao_t *pos = &motor->pos;
+    int lance;
+
+    switch (seletor->estagio)
     {
-        return 1; // Não precisa ordenar se tem 0 ou 1 lance
-    }
+    case ESTAGIO_HASH:
+        while (seletor->indice < 2)
+        {
+            lance = seletor->prioritarios[seletor->indice++];
+            if (lance)
+            {
+                return lance;
+            }
+        }
+        seletor->estagio = ESTAGIO_GERAR_CAPTURAS;
+        /* fall through */
 
-    // Calcular scores para todos os lances
-    int move_scores[listaLances->contador];
-    for (int i = 0; i < listaLances->contador; i++)
+    case ESTAGIO_GERAR_CAPTURAS:
+        gerar_capturas(pos, &seletor->lista);
+        for (int i = 0; i < seletor->lista.contador; i++)
+        {
+            int captura = seletor->lista.lances[i];
+            seletor->scores[i] = get_mvv_lva_score(get_peca(captura), pos->peca_na_casa[get_destino(captura)]);
+        }
+        seletor->indice = 0;
+        seletor->estagio = ESTAGIO_CAPTURAS_BOAS;
+        /* fall through */
+
+    case ESTAGIO_CAPTURAS_BOAS:
+        while ((lance = selecionar_melhor(seletor)))
+        {
+            if (lance_prioritario(seletor, lance))
+            {
+                continue;
+            }
+
+            // Perdedora: guardada numa casa já consumida da lista para o último estágio
+            if (!get_peca_promovida(lance) && captura_perdedora(pos, lance))
+            {
+                seletor->lista.lances[seletor->num_ruins++] = lance;
+                continue;
+            }
+
+            return lance;
+        }
+
+        if (seletor->somente_capturas)
+        {
+            seletor->estagio = ESTAGIO_FIM;
+            return 0;
+        }
+
+        seletor->indice = 0;
+        seletor->estagio = ESTAGIO_KILLERS;
+        /* fall through */
+
+    case ESTAGIO_KILLERS:
+        while (seletor->indice < 2)
+        {
+            lance = motor->killer_moves[seletor->indice][motor->ply];
+
+            // killers[] guarda os que foram devolvidos, para não repeti-los nos quietos
+            if (lance && !get_captura(lance) && !lance_prioritario(seletor, lance) &&
+                lance != seletor->killers[0] && lance_valido(pos, lance))
+            {
+                seletor->killers[seletor->indice++] = lance;
+                return lance;
+            }
+
+            seletor->indice++;
+        }
+        seletor->estagio = ESTAGIO_GERAR_QUIETOS;
+        /* fall through */
+
+    case ESTAGIO_GERAR_QUIETOS:
     {
-        move_scores[i] = score_move(listaLances->lances[i]);
+        lances quietos;
+        gerar_quietos(pos, &quietos);
+
+        // Os quietos ocupam a lista logo depois das capturas perdedoras
+        seletor->indice = seletor->num_ruins;
+        seletor->lista.contador = seletor->num_ruins;
+        for (int i = 0; i < quietos.contador; i++)
+        {
+            int quieto = quietos.lances[i];
+            seletor->lista.lances[seletor->lista.contador] = quieto;
+            seletor->scores[seletor->lista.contador++] = pontuar_quieto(motor, quieto);
+        }
+        seletor->estagio = ESTAGIO_QUIETOS;
     }
+        /* fall through */
 
-    // Ordenação por quicksort (muito mais eficiente que bubble sort)
-    // Ordena do maior score para o menor (melhores capturas primeiro)
-    quicksort_moves(listaLances, move_scores, 0, listaLances->contador - 1);
+    case ESTAGIO_QUIETOS:
+        while ((lance = selecionar_melhor(seletor)))
+        {
+            if (lance_prioritario(seletor, lance) || lance == seletor->killers[0] || lance == seletor->killers[1])
+            {
+                continue;
+            }
+
+            return lance;
+        }
+        seletor->indice = 0;
+        seletor->estagio = ESTAGIO_CAPTURAS_RUINS;
+        /* fall through */
 
-    return 1;
+    case ESTAGIO_CAPTURAS_RUINS:
+        if (seletor->indice < seletor->num_ruins)
+        {
+            return seletor->lista.lances[seletor->indice++];
+        }
+        seletor->estagio = ESTAGIO_FIM;
+        /* fall through */
+
+    default:
+        return 0;
+    }
 }
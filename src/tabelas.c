@@ -0,0 +1,135 @@
+/**
+ * @file tabelas.c
+ * @brief Implementação da exportação das tabelas pré-calculadas da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este arquivo escreve as tabelas preenchidas por runEngine() como um arquivo
+ * C com dados const (src/tabelas_geradas.c em "make tabelas").
+ */
+
+#include "../include/tabelas.h"
+#include "../include/bitboard.h"
+#include "../include/globals.h"
+#include "../include/evaluate.h"
+
+#include <stdio.h>
+
+// =============================================================================
+// ESCRITA DOS DADOS
+// =============================================================================
+
+// Escreve os valores entre chaves, quatro por linha
+static void escrever_valores(FILE *saida, const u64 *valores, int quantidade, const char *recuo)
+{
+    fprintf(saida, "{\n");
+    for (int i = 0; i < quantidade; i++)
+    {
+        if (i % 4 == 0)
+            fprintf(saida, "%s    ", recuo);
+
+        fprintf(saida, "0x%016llxULL,", valores[i]);
+        fprintf(saida, (i % 4 == 3 || i == quantidade - 1) ? "\n" : " ");
+    }
+    fprintf(saida, "%s}", recuo);
+}
+
+// Escreve "declaracao = {...};" para uma tabela de 1 ou 2 dimensões
+static void escrever_tabela(FILE *saida, const char *declaracao, const u64 *valores, int linhas, int colunas)
+{
+    fprintf(saida, "%s = ", declaracao);
+
+    if (linhas == 1)
+    {
+        escrever_valores(saida, valores, colunas, "");
+    }
+    else
+    {
+        fprintf(saida, "{\n");
+        for (int linha = 0; linha < linhas; linha++)
+        {
+            fprintf(saida, "    ");
+            escrever_valores(saida, valores + linha * colunas, colunas, "    ");
+            fprintf(saida, ",\n");
+        }
+        fprintf(saida, "}");
+    }
+
+    fprintf(saida, ";\n\n");
+}
+
+// Ponteiros por casa escritos como deslocamentos em tabela_ataques_deslizantes
+static void escrever_trechos(FILE *saida, const char *declaracao, const u64 *const trechos[64])
+{
+    fprintf(saida, "%s = {\n", declaracao);
+    for (int casa = 0; casa < 64; casa++)
+    {
+        fprintf(saida, "    tabela_ataques_deslizantes + %ld,\n",
+                (long)(trechos[casa] - tabela_ataques_deslizantes));
+    }
+    fprintf(saida, "};\n\n");
+}
+
+// =============================================================================
+// EXPORTAÇÃO DAS TABELAS
+// =============================================================================
+
+int exportar_tabelas(const char *arquivo)
+{
+    FILE *saida = fopen(arquivo, "w");
+    if (!saida)
+    {
+        printf("Erro: nao foi possivel criar %s\n", arquivo);
+        return 1;
+    }
+
+    fprintf(saida, "/*\n"
+                   " * Gerado por \"maze gerartabelas\" (make tabelas): nao edite.\n"
+                   " * Tabelas de ataque e mascaras da avaliacao como dados const.\n"
+                   " */\n\n"
+                   "#include \"../include/globals.h\"\n"
+                   "#include \"../include/evaluate.h\"\n\n"
+                   "#ifndef TABELAS_PRECALCULADAS\n"
+                   "#error \"tabelas_geradas.c exige -DTABELAS_PRECALCULADAS\"\n"
+                   "#endif\n\n");
+
+    // Os trechos de bispos e torres são indexados de forma diferente em cada backend
+#ifdef USAR_PEXT
+    fprintf(saida, "#ifndef USAR_PEXT\n"
+                   "#error \"tabelas geradas com indice PEXT: compile com -DUSAR_PEXT -mbmi2\"\n"
+                   "#endif\n\n");
+#else
+    fprintf(saida, "#ifdef USAR_PEXT\n"
+                   "#error \"tabelas geradas com indice magico: compile sem -DUSAR_PEXT\"\n"
+                   "#endif\n\n");
+#endif
+
+    escrever_tabela(saida, "const u64 tabela_ataques_peao[2][64]", &tabela_ataques_peao[0][0], 2, 64);
+    escrever_tabela(saida, "const u64 tabela_ataques_cavalo[64]", tabela_ataques_cavalo, 1, 64);
+    escrever_tabela(saida, "const u64 tabela_ataques_rei[64]", tabela_ataques_rei, 1, 64);
+    escrever_tabela(saida, "const u64 mask_tabela_ataques_bispo[64]", mask_tabela_ataques_bispo, 1, 64);
+    escrever_tabela(saida, "const u64 mask_tabela_ataques_torre[64]", mask_tabela_ataques_torre, 1, 64);
+
+    escrever_tabela(saida, "_Alignas(64) const u64 tabela_ataques_deslizantes[TAMANHO_ATAQUES_BISPO + TAMANHO_ATAQUES_TORRE]",
+                    tabela_ataques_deslizantes, 1, TAMANHO_ATAQUES_BISPO + TAMANHO_ATAQUES_TORRE);
+    escrever_trechos(saida, "const u64 *const ataques_bispo[64]", (const u64 *const *)ataques_bispo);
+    escrever_trechos(saida, "const u64 *const ataques_torre[64]", (const u64 *const *)ataques_torre);
+
+    escrever_tabela(saida, "const u64 casas_entre[64][64]", &casas_entre[0][0], 64, 64);
+    escrever_tabela(saida, "const u64 linha_casas[64][64]", &linha_casas[0][0], 64, 64);
+
+    escrever_tabela(saida, "const u64 coluna_masks[64]", coluna_masks, 1, 64);
+    escrever_tabela(saida, "const u64 linha_masks[64]", linha_masks, 1, 64);
+    escrever_tabela(saida, "const u64 peao_isolado_masks[64]", peao_isolado_masks, 1, 64);
+    escrever_tabela(saida, "const u64 peao_passado_branco_masks[64]", peao_passado_branco_masks, 1, 64);
+    escrever_tabela(saida, "const u64 peao_passado_preto_masks[64]", peao_passado_preto_masks, 1, 64);
+
+    int erro = ferror(saida);
+    if (fclose(saida) != 0 || erro)
+    {
+        printf("Erro: falha ao escrever %s\n", arquivo);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,120 @@
+/**
+ * @file tempo.c
+ * @brief Implementação do controle de tempo da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este arquivo implementa a divisão do tempo de relógio entre os lances e a
+ * verificação periódica do relógio durante a busca.
+ */
+
+#include "../include/tempo.h"
+#include "../include/ataques.h"
+
+// =============================================================================
+// FUNÇÕES DE CONTROLE DE TEMPO
+// =============================================================================
+
+void init_tempo(controle_tempo_t *controle, int tempo_restante, int incremento, int movestogo, int movetime, int infinito, int ponder)
+{
+    controle->inicio = get_tempo_milisegundos();
+    controle->ativo = 0;
+    controle->pode_parar = 0;
+    controle->limite_suave = 0;
+    controle->limite_rigido = 0;
+    controle->infinito = infinito;
+    controle->ponder = ponder;
+    controle->parar = 0;
+
+    if (infinito)
+        return;
+
+    if (movetime > 0)
+    {
+        // Tempo fixo: usa tudo, descontando a margem
+        int limite = movetime - MARGEM_TEMPO;
+        if (limite < 1)
+            limite = 1;
+
+        controle->ativo = 1;
+        controle->limite_suave = limite;
+        controle->limite_rigido = limite;
+    }
+    else if (tempo_restante > 0)
+    {
+        int lances = (movestogo > 0) ? movestogo : LANCES_ATE_CONTROLE_PADRAO;
+
+        // Nunca planejar usar mais do que o relógio permite
+        int disponivel = tempo_restante - MARGEM_TEMPO;
+        if (disponivel < 1)
+            disponivel = 1;
+
+        // Fatia do lance: tempo restante dividido pelos lances + 3/4 do incremento
+        int fatia = tempo_restante / lances + (incremento * 3) / 4;
+
+        int suave = fatia;
+        int rigido = fatia * 4;
+
+        // Em um único lance não se gasta mais que 1/3 do relógio
+        if (rigido > disponivel / 3 && movestogo != 1)
+            rigido = disponivel / 3;
+        if (rigido > disponivel)
+            rigido = disponivel;
+        if (suave > rigido)
+            suave = rigido;
+
+        controle->ativo = 1;
+        controle->limite_suave = (suave < 1) ? 1 : suave;
+        controle->limite_rigido = (rigido < 1) ? 1 : rigido;
+    }
+}
+
+void tempo_ponderhit(controle_tempo_t *controle)
+{
+    // O relógio do lance passa a correr agora
+    controle->inicio = get_tempo_milisegundos();
+    controle->ponder = 0;
+}
+
+int aguardando_stop(const controle_tempo_t *controle)
+{
+    return controle->infinito || controle->ponder;
+}
+
+int tempo_decorrido(const controle_tempo_t *controle)
+{
+    return get_tempo_milisegundos() - controle->inicio;
+}
+
+void verificar_tempo(controle_tempo_t *controle)
+{
+    if (!controle->ativo || !controle->pode_parar || controle->ponder)
+        return;
+
+    if (tempo_decorrido(controle) >= controle->limite_rigido)
+    {
+        controle->parar = 1;
+    }
+}
+
+int iniciar_proxima_iteracao(const controle_tempo_t *controle, int tempo_ultima_iteracao)
+{
+    if (controle->parar)
+        return 0;
+
+    if (!controle->ativo || controle->ponder)
+        return 1;
+
+    int decorrido = tempo_decorrido(controle);
+
+    // Passou do limite suave: não começar outra iteração
+    if (decorrido >= controle->limite_suave)
+        return 0;
+
+    // A próxima iteração custa tipicamente ~2x a anterior; se não deve
+    // terminar antes do limite rígido, seria tempo jogado fora
+    if (decorrido + tempo_ultima_iteracao * 2 > controle->limite_rigido)
+        return 0;
+
+    return 1;
+}
@@ -0,0 +1,341 @@
+/**
+ * @file transposicao.c
+ * @brief Implementação da tabela de transposição da engine MaZe
+ * @author GustavoGNZ
+ * @version 1.0
+ *
+ * Este arquivo implementa a tabela de transposição usada por negamax() e
+ * quiescence(). Cada bucket ocupa exatamente uma linha de cache (64 bytes)
+ * com 4 entradas, de modo que uma sondagem custa no máximo um cache miss.
+ * A tabela é compartilhada pelas threads do Lazy SMP sem travas; entradas
+ * corrompidas por escritas concorrentes são descartadas pela verificação.
+ */
+
+#include "../include/transposicao.h"
+#include "../include/search.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// =============================================================================
+// ESTADO DA TABELA DE TRANSPOSIÇÃO
+// =============================================================================
+
+/**
+ * @brief Vetor de buckets da tabela (alinhado a 64 bytes dentro de memoria_tt)
+ */
+static bucket_tt *tabela_tt = NULL;
+
+/**
+ * @brief Bloco devolvido por calloc, liberado em finalizar_tt()
+ */
+static void *memoria_tt = NULL;
+
+/**
+ * @brief Máscara para indexar os buckets (num_buckets - 1)
+ */
+static u64 mascara_tt = 0;
+
+/**
+ * @brief Tamanho pedido na última alocação da tabela, em MB
+ */
+static int megabytes_tt = 0;
+
+/**
+ * @brief Geração atual da busca, usada na política de substituição
+ */
+static unsigned short geracao_tt = 0;
+
+/**
+ * @brief Vetor de entradas da tabela do perft (NULL = desligada)
+ */
+static entrada_tt_perft *tabela_tt_perft = NULL;
+
+/**
+ * @brief Máscara para indexar a tabela do perft (num_entradas - 1)
+ */
+static u64 mascara_tt_perft = 0;
+
+// =============================================================================
+// FUNÇÕES AUXILIARES
+// =============================================================================
+
+/**
+ * @brief Converte score de mate relativo à raiz para relativo ao nó
+ *
+ * Scores de mate dependem da distância até a raiz (-99999 + ply). Na tabela
+ * eles são guardados como distância até o nó, para continuarem corretos
+ * quando a mesma posição aparece em outro ply.
+ */
+static int score_para_tt(int score, int ply)
+{
+    if (score > LIMITE_MATE)
+        return score + ply;
+    if (score < -LIMITE_MATE)
+        return score - ply;
+    return score;
+}
+
+/**
+ * @brief Converte score de mate armazenado de volta para relativo à raiz
+ */
+static int score_de_tt(int score, int ply)
+{
+    if (score > LIMITE_MATE)
+        return score - ply;
+    if (score < -LIMITE_MATE)
+        return score + ply;
+    return score;
+}
+
+/**
+ * @brief Campos da entrada (exceto a verificação) combinados em 32 bits
+ */
+static inline unsigned int dados_entrada(const entrada_tt *entrada)
+{
+    return (unsigned int)entrada->lance
+         ^ (unsigned int)entrada->score
+         ^ ((unsigned int)entrada->profundidade
+            | ((unsigned int)entrada->flag << 8)
+            | ((unsigned int)entrada->geracao << 16));
+}
+
+/**
+ * @brief Verifica se a entrada pertence à chave e foi escrita por inteiro
+ */
+static inline int entrada_valida(const entrada_tt *entrada, unsigned int verificacao)
+{
+    return entrada->flag != 0 && (entrada->verificacao ^ dados_entrada(entrada)) == verificacao;
+}
+
+// =============================================================================
+// GERENCIAMENTO DA TABELA
+// =============================================================================
+
+void inicializar_tt(int megabytes)
+{
+    if (megabytes < 1)
+        megabytes = 1;
+    if (megabytes > TT_TAMANHO_MAXIMO_MB)
+        megabytes = TT_TAMANHO_MAXIMO_MB;
+
+    finalizar_tt();
+    megabytes_tt = megabytes;
+
+    // Maior potência de dois de buckets que cabe no tamanho pedido
+    u64 num_buckets = ((u64)megabytes * 1024 * 1024) / sizeof(bucket_tt);
+    u64 potencia = 1;
+    while (potencia * 2 <= num_buckets)
+        potencia *= 2;
+
+    // calloc de blocos grandes recebe páginas já zeradas do sistema, que só
+    // são tocadas no primeiro acesso: a inicialização não varre a tabela.
+    // A folga de 63 bytes permite alinhar o início a uma linha de cache.
+    memoria_tt = calloc(1, potencia * sizeof(bucket_tt) + 63);
+
+    if (memoria_tt == NULL)
+    {
+        printf("info string Erro ao alocar tabela de transposicao de %d MB\n", megabytes);
+        mascara_tt = 0;
+        return;
+    }
+
+    tabela_tt = (bucket_tt *)(((uintptr_t)memoria_tt + 63) & ~(uintptr_t)63);
+    mascara_tt = potencia - 1;
+    geracao_tt = 0;
+}
+
+void limpar_tt()
+{
+    if (tabela_tt != NULL)
+    {
+        memset(tabela_tt, 0, (mascara_tt + 1) * sizeof(bucket_tt));
+    }
+    geracao_tt = 0;
+}
+
+void finalizar_tt()
+{
+    free(memoria_tt);
+    memoria_tt = NULL;
+    tabela_tt = NULL;
+    mascara_tt = 0;
+}
+
+int tamanho_tt_mb()
+{
+    return megabytes_tt;
+}
+
+void nova_busca_tt()
+{
+    geracao_tt++;
+}
+
+// =============================================================================
+// SONDAGEM E GRAVAÇÃO
+// =============================================================================
+
+int sondar_tt(u64 chave, int profundidade, int alpha, int beta, int ply, int *lance)
+{
+    *lance = 0;
+
+    if (tabela_tt == NULL)
+        return SEM_ENTRADA_HASH;
+
+    bucket_tt *bucket = &tabela_tt[chave & mascara_tt];
+    unsigned int verificacao = (unsigned int)(chave >> 32);
+
+    for (int i = 0; i < TT_ENTRADAS_POR_BUCKET; i++)
+    {
+        // Cópia local: outra thread pode reescrever a entrada durante a leitura
+        entrada_tt entrada = bucket->entradas[i];
+
+        if (!entrada_valida(&entrada, verificacao))
+            continue;
+
+        *lance = entrada.lance;
+
+        if (entrada.profundidade >= profundidade)
+        {
+            int score = score_de_tt(entrada.score, ply);
+
+            if (entrada.flag == hash_exato)
+                return score;
+
+            if (entrada.flag == hash_alfa && score <= alpha)
+                return alpha;
+
+            if (entrada.flag == hash_beta && score >= beta)
+                return beta;
+        }
+
+        break;
+    }
+
+    return SEM_ENTRADA_HASH;
+}
+
+void gravar_tt(u64 chave, int profundidade, int score, int flag, int lance, int ply)
+{
+    if (tabela_tt == NULL)
+        return;
+
+    bucket_tt *bucket = &tabela_tt[chave & mascara_tt];
+    unsigned int verificacao = (unsigned int)(chave >> 32);
+
+    entrada_tt *substituir = &bucket->entradas[0];
+    int menor_valor = 1 << 30;
+
+    for (int i = 0; i < TT_ENTRADAS_POR_BUCKET; i++)
+    {
+        entrada_tt *entrada = &bucket->entradas[i];
+
+        // Mesma posição: sobrescreve, a menos que a entrada antiga seja bem mais profunda
+        if (entrada_valida(entrada, verificacao))
+        {
+            if (flag != hash_exato && profundidade + 2 < entrada->profundidade)
+                return;
+
+            substituir = entrada;
+            break;
+        }
+
+        // Caso contrário, substitui a entrada mais rasa, preferindo as de buscas antigas
+        int valor = entrada->profundidade - ((entrada->geracao != geracao_tt) ? 256 : 0);
+        if (valor < menor_valor)
+        {
+            menor_valor = valor;
+            substituir = entrada;
+        }
+    }
+
+    // Mantém o lance antigo se a nova busca não encontrou um melhor lance
+    if (lance == 0 && entrada_valida(substituir, verificacao))
+        lance = substituir->lance;
+
+    // Monta a entrada completa antes de copiá-la para a tabela
+    entrada_tt nova;
+    nova.lance = lance;
+    nova.score = score_para_tt(score, ply);
+    nova.profundidade = (unsigned char)(profundidade < 0 ? 0 : profundidade);
+    nova.flag = (unsigned char)flag;
+    nova.geracao = geracao_tt;
+    nova.verificacao = verificacao ^ dados_entrada(&nova);
+
+    *substituir = nova;
+}
+
+// =============================================================================
+// TABELA DO PERFT
+// =============================================================================
+
+/**
+ * @brief Índice da entrada: a profundidade entra no índice para que a mesma
+ * posição em profundidades diferentes não dispute a mesma entrada
+ */
+static inline u64 indice_tt_perft(u64 chave, int profundidade)
+{
+    return (chave ^ ((u64)profundidade * 0x9E3779B97F4A7C15ULL)) & mascara_tt_perft;
+}
+
+void inicializar_tt_perft(int megabytes)
+{
+    if (megabytes < 0)
+        megabytes = 0;
+    if (megabytes > TT_TAMANHO_MAXIMO_MB)
+        megabytes = TT_TAMANHO_MAXIMO_MB;
+
+    free(tabela_tt_perft);
+    tabela_tt_perft = NULL;
+    mascara_tt_perft = 0;
+
+    if (megabytes == 0)
+        return;
+
+    // Maior potência de dois de entradas que cabe no tamanho pedido
+    u64 num_entradas = ((u64)megabytes * 1024 * 1024) / sizeof(entrada_tt_perft);
+    u64 potencia = 1;
+    while (potencia * 2 <= num_entradas)
+        potencia *= 2;
+
+    tabela_tt_perft = calloc(potencia, sizeof(entrada_tt_perft));
+
+    if (tabela_tt_perft == NULL)
+    {
+        printf("info string Erro ao alocar tabela do perft de %d MB\n", megabytes);
+        return;
+    }
+
+    mascara_tt_perft = potencia - 1;
+}
+
+int sondar_tt_perft(u64 chave, int profundidade, long *nos)
+{
+    if (tabela_tt_perft == NULL)
+        return 0;
+
+    // Cópia local: outra thread pode reescrever a entrada durante a leitura
+    entrada_tt_perft entrada = tabela_tt_perft[indice_tt_perft(chave, profundidade)];
+
+    if ((entrada.verificacao ^ entrada.dados) != chave || (int)(entrada.dados & 0xFF) != profundidade)
+        return 0;
+
+    *nos = (long)(entrada.dados >> 8);
+    return 1;
+}
+
+void gravar_tt_perft(u64 chave, int profundidade, long nos)
+{
+    if (tabela_tt_perft == NULL)
+        return;
+
+    // Sempre substitui: subárvores recentes são as mais prováveis de se repetir
+    entrada_tt_perft nova;
+    nova.dados = ((u64)nos << 8) | (u64)(profundidade & 0xFF);
+    nova.verificacao = chave ^ nova.dados;
+
+    tabela_tt_perft[indice_tt_perft(chave, profundidade)] = nova;
+}
@@ -8,6 +8,7 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <pthread.h>
 #include "../include/bitboard.h"
 #include "../include/ataques.h"
 #include "../include/globals.h"
@@ -15,10 +16,26 @@
 #include "../include/search.h"
 #include "../include/evaluate.h"
 #include "../include/aberturas.h"
+#include "../include/transposicao.h"
+#include "../include/tempo.h"
+#include "../include/bench.h"
 
 // Posição inicial padrão em notação FEN
 #define posicaoInicial "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 
+// Thread de busca, profundidade e posição pedidas no último "go"
+// (a busca recebe uma cópia, a posição do loop UCI pode mudar durante a busca)
+static pthread_t thread_busca;
+static int busca_em_andamento = 0;
+static int profundidade_busca = 0;
+static int perft_na_thread = 0; // 1 se a thread roda "go perft" em vez de busca_lance()
+static posicao_t posicao_busca;
+
+// Estado da busca do loop UCI: contextos das threads, relógio e sinal de parada
+static int num_threads_busca = 1; // setoption Threads (1 = sem Lazy SMP)
+static motor_t motores_busca[MAX_THREADS_BUSCA];
+static controle_tempo_t controle_busca;
+
 void lance_para_uci(int lance, char* buffer) {
     // Extract move components from internal format
     int origem = get_origem(lance);
@@ -46,12 +63,12 @@ void lance_para_uci(int lance, char* buffer) {
     }
 }
 
-int parse_move(char *string_lance)
+int parse_move(const posicao_t *pos, char *string_lance)
 {
     lances listaLances[1];
 
     // Gera todos os lances legais para a posição atual
-    gerar_lances(listaLances);
+    gerar_lances(pos, listaLances);
 
     // Calcula casa de origem (a1=0, b1=1, ..., h8=63)
     int origem = (string_lance[0] - 'a') + (string_lance[1] - '1') * 8;
@@ -101,19 +118,16 @@ int parse_move(char *string_lance)
 }
 
 // uci
-void parse_position(char *string_posicao)
+void parse_position(posicao_t *pos, char *string_posicao)
 {
 
     string_posicao += 9; // pula "position "
 
     char *token = string_posicao;
 
-    // Limpa o histórico da partida ao configurar nova posição
-    num_lances_partida = 0;
-
     if (strncmp(string_posicao, "startpos", 8) == 0)
     {
-        parseFEN(posicaoInicial);
+        parseFEN(pos, posicaoInicial);
     }
     else
     {
@@ -121,12 +135,12 @@ void parse_position(char *string_posicao)
 
         if (token == NULL)
         {
-            parseFEN(posicaoInicial);
+            parseFEN(pos, posicaoInicial);
         }
         else
         {
             token += 4; // pula "fen "
-            parseFEN(token);
+            parseFEN(pos, token);
         }
     }
 
@@ -159,17 +173,13 @@ void parse_position(char *string_posicao)
 
             if (strlen(lance_str) >= 4) // lance válido deve ter pelo menos 4 caracteres
             {
-                int lance = parse_move(lance_str);
+                int lance = parse_move(pos, lance_str);
 
                 if (lance != 0)
                 {
-                    // Adiciona o lance ao histórico da partida
-                    if (num_lances_partida < MAX_LANCES_PARTIDA) {
-                        historico_lances_partida[num_lances_partida] = lance;
-                        num_lances_partida++;
-                    }
-                    
-                    if (!fazer_lance(lance, todosLances, backup_global))
+                    registro_desfazer desfazer;
+
+                    if (!fazer_lance(pos, lance, todosLances, &desfazer))
                     {
                         break; // Erro ao executar lance
                     }
@@ -189,16 +199,25 @@ void parse_position(char *string_posicao)
     }
 }
 
-void parse_go(char *string_go)
+void parse_go(const posicao_t *pos, char *string_go)
 {
     int profundidade = -1;
     int tempo_branco = -1, tempo_preto = -1;
     int inc_branco = 0, inc_preto = 0;
     int movetime = -1;
+    int movestogo = 0;
     int infinite = 0;
+    int ponder = 0;
 
     char *token = NULL;
 
+    // "go perft N": contagem de nós para validar o gerador, sem busca
+    if ((token = strstr(string_go, "perft")))
+    {
+        iniciar_perft(pos, atoi(token + 6));
+        return;
+    }
+
     // Parse depth
     if ((token = strstr(string_go, "depth")))
     {
@@ -229,6 +248,12 @@ void parse_go(char *string_go)
         inc_preto = atoi(token + 5);
     }
 
+    // Parse movestogo (lances até o próximo controle de tempo)
+    if ((token = strstr(string_go, "movestogo")))
+    {
+        movestogo = atoi(token + 10);
+    }
+
     // Parse movetime (tempo fixo para o lance em ms)
     if ((token = strstr(string_go, "movetime")))
     {
@@ -241,51 +266,145 @@ void parse_go(char *string_go)
         infinite = 1;
     }
 
-    // PRIMEIRO: Consultar livro de aberturas
-    if (livro_aberturas.inicializado) {
-        int lance_livro = buscar_lance_abertura(historico_lances_partida, num_lances_partida);
-        
+    // Parse ponder (bestmove só depois de "ponderhit" ou "stop")
+    if (strstr(string_go, "ponder"))
+    {
+        ponder = 1;
+    }
+
+    // PRIMEIRO: Consultar livro de aberturas pela chave da posição (ao ponderar, a GUI espera a busca)
+    if (livro_aberturas.inicializado && !ponder) {
+        int lance_livro = buscar_lance_abertura(pos);
+
         if (lance_livro != 0) {
-            // Verificar se o lance é válido na posição atual
-            lances listaLances[1];
-            gerar_lances(listaLances);
-            
-            for (int i = 0; i < listaLances->contador; i++) {
-                if (listaLances->lances[i] == lance_livro) {
-                    printf("bestmove ");
-                    printLance(lance_livro);
-                    printf("\n");
-                    fflush(stdout);
-                    return;
-                }
-            }
-            printf("info string Lance do livro inválido na posição atual\n");
+            printf("bestmove ");
+            printLance(lance_livro);
+            printf("\n");
+            fflush(stdout);
+            return;
         }
     }
 
     // Configurar controle de tempo
+    int tempo_restante = (pos->lado_a_jogar == branco) ? tempo_branco : tempo_preto;
+    int incremento = (pos->lado_a_jogar == branco) ? inc_branco : inc_preto;
+
     if (infinite) {
         // Busca infinita - sem limite de tempo
-        // controle_tempo.tempo_total = 0;
-        profundidade = (profundidade == -1) ? 64 : profundidade;
+        init_tempo(&controle_busca, -1, 0, 0, -1, 1, ponder);
+        profundidade = (profundidade == -1) ? MAX_PLY_BUSCA : profundidade;
     } else if (movetime > 0) {
         // Tempo fixo por lance
-        // controle_tempo.tempo_total = movetime;
-        // controle_tempo.incremento = 0;
-        // controle_tempo.tempo_restante = movetime;
-        profundidade = 64; // Buscar até o tempo esgotar
-    } else if (tempo_branco > 0 || tempo_preto > 0) {
+        init_tempo(&controle_busca, -1, 0, 0, movetime, 0, ponder);
+        profundidade = (profundidade == -1) ? MAX_PLY_BUSCA : profundidade; // Buscar até o tempo esgotar
+    } else if (tempo_restante > 0) {
         // Controle de tempo normal
-        // init_tempo(tempo_branco, tempo_preto, inc_branco, inc_preto);
-        profundidade = 64; // Buscar até o tempo esgotar
+        init_tempo(&controle_busca, tempo_restante, incremento, movestogo, -1, 0, ponder);
+        profundidade = (profundidade == -1) ? MAX_PLY_BUSCA : profundidade; // Buscar até o tempo esgotar
     } else {
         // Sem parâmetros de tempo - usar profundidade padrão
-        // controle_tempo.tempo_total = 0;
+        init_tempo(&controle_busca, -1, 0, 0, -1, 0, ponder);
         profundidade = (profundidade == -1) ? 6 : profundidade;
     }
 
-    // Se não encontrou no livro, faz busca normal
-    busca_lance(profundidade);
+    // Se não encontrou no livro, faz busca normal em segundo plano
+    iniciar_busca(pos, profundidade);
+}
+
+static void *executar_busca(void *argumento)
+{
+    (void)argumento;
+    if (perft_na_thread)
+        perft_divide(&posicao_busca, profundidade_busca, num_threads_busca, &controle_busca.parar);
+    else
+        busca_lance(motores_busca, num_threads_busca, &controle_busca, &posicao_busca, profundidade_busca);
+    return NULL;
+}
+
+// Roda busca_lance() ou perft_divide() na thread de busca
+static void iniciar_thread_busca(const posicao_t *pos, int profundidade, int perft)
+{
+    interromper_busca();
+
+    // Na busca o sinal é limpo por init_tempo(); no perft, aqui
+    if (perft)
+        controle_busca.parar = 0;
+
+    profundidade_busca = profundidade;
+    posicao_busca = *pos;
+    perft_na_thread = perft;
+
+    pthread_attr_t atributos;
+    pthread_attr_init(&atributos);
+    pthread_attr_setstacksize(&atributos, TAMANHO_PILHA_BUSCA);
+
+    if (pthread_create(&thread_busca, &atributos, executar_busca, NULL) == 0)
+    {
+        busca_em_andamento = 1;
+    }
+    else
+    {
+        // Sem thread disponível: execução síncrona como antes
+        executar_busca(NULL);
+    }
+
+    pthread_attr_destroy(&atributos);
+}
+
+void iniciar_busca(const posicao_t *pos, int profundidade)
+{
+    iniciar_thread_busca(pos, profundidade, 0);
+}
+
+void iniciar_perft(const posicao_t *pos, int profundidade)
+{
+    iniciar_thread_busca(pos, profundidade, 1);
+}
+
+void aguardar_busca()
+{
+    if (!busca_em_andamento)
+    {
+        return;
+    }
+
+    pthread_join(thread_busca, NULL);
+    busca_em_andamento = 0;
+}
+
+void interromper_busca()
+{
+    if (!busca_em_andamento)
+    {
+        return;
+    }
+
+    controle_busca.parar = 1;
+    aguardar_busca();
+}
+
+void parse_setoption(char *string_opcao)
+{
+    char *token = NULL;
+
+    // setoption name Hash value <MB>
+    if ((token = strstr(string_opcao, "name Hash value")))
+    {
+        inicializar_tt(atoi(token + 16));
+    }
+
+    // setoption name PerftHash value <MB> (0 desliga)
+    if ((token = strstr(string_opcao, "name PerftHash value")))
+    {
+        inicializar_tt_perft(atoi(token + 21));
+    }
+
+    // setoption name Threads value <N>
+    if ((token = strstr(string_opcao, "name Threads value")))
+    {
+        int threads = atoi(token + 19);
+        num_threads_busca = (threads < 1) ? 1 : (threads > MAX_THREADS_BUSCA) ? MAX_THREADS_BUSCA : threads;
+    }
 }
 
 void uci_loop()
@@ -297,6 +416,11 @@ void uci_loop()
     // Carrega o livro de aberturas na inicialização
     inicializar_livro_aberturas();
 
+    // Posição da partida mantida pelo loop UCI
+    posicao_t posicao;
+    posicao_t *pos = &posicao;
+    parseFEN(pos, posicaoInicial);
+
     char comando[4096];
     while (1)
     {
@@ -306,7 +430,13 @@ void uci_loop()
 
         if (fgets(comando, sizeof(comando), stdin) == NULL)
         {
-            continue; // Se falhar ao ler, tenta novamente
+            // Fim da entrada: deixa a busca atual terminar (uma busca infinita é parada)
+            if (aguardando_stop(&controle_busca))
+            {
+                controle_busca.parar = 1;
+            }
+            aguardar_busca();
+            break;
         }
 
         // Remove nova linha do final do comando
@@ -317,29 +447,74 @@ void uci_loop()
         {
             printf("id name MaZe 1.0\n");
             printf("id author GustavoGNZ\n");
+            printf("option name Hash type spin default %d min 1 max %d\n", TT_TAMANHO_PADRAO_MB, TT_TAMANHO_MAXIMO_MB);
+            printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS_BUSCA);
+            printf("option name PerftHash type spin default %d min 0 max %d\n", TT_PERFT_TAMANHO_PADRAO_MB, TT_TAMANHO_MAXIMO_MB);
             printf("uciok\n");
         }
         else if (strcmp(comando, "ucinewgame") == 0)
         {
+            interromper_busca();
             // Reinicia o jogo para uma nova partida
             // limpar_historico_partida();
-            parse_position("position startpos");
+            limpar_tt();
+            parse_position(pos, "position startpos");
         }
         else if (strncmp(comando, "isready", 7) == 0)
         {
             printf("readyok\n");
         }
+        else if (strncmp(comando, "setoption", 9) == 0)
+        {
+            interromper_busca();
+            parse_setoption(comando);
+        }
         else if (strncmp(comando, "position", 8) == 0)
         {
-            parse_position(comando);
+            interromper_busca();
+            parse_position(pos, comando);
             // printTabuleiro();
         }
         else if (strncmp(comando, "go", 2) == 0)
         {
-            parse_go(comando);
+            interromper_busca();
+            parse_go(pos, comando);
+        }
+        else if (strncmp(comando, "bench", 5) == 0)
+        {
+            // bench [profundidade] [threads] [hash]
+            int profundidade = 0, threads = 0, hash_mb = 0;
+
+            interromper_busca();
+            sscanf(comando + 5, "%d %d %d", &profundidade, &threads, &hash_mb);
+            executar_bench(profundidade, threads, hash_mb);
+        }
+        else if (strncmp(comando, "perftsuite", 10) == 0)
+        {
+            // perftsuite <arquivo.epd> [profundidade máxima] [hash do perft em MB]
+            char arquivo[1024];
+            int profundidade_maxima = 0;
+            int hash_perft = -1;
+
+            interromper_busca();
+            if (sscanf(comando + 10, " %1023s %d %d", arquivo, &profundidade_maxima, &hash_perft) >= 1)
+            {
+                if (hash_perft >= 0)
+                    inicializar_tt_perft(hash_perft);
+                perft_suite(arquivo, profundidade_maxima, 0);
+            }
+        }
+        else if (strncmp(comando, "stop", 4) == 0)
+        {
+            interromper_busca();
+        }
+        else if (strncmp(comando, "ponderhit", 9) == 0)
+        {
+            tempo_ponderhit(&controle_busca);
         }
         else if (strncmp(comando, "quit", 4) == 0)
         {
+            interromper_busca();
             break;
         }
     }